@@ -29,6 +29,8 @@
 
 void setupAHK(); ///< Setup the AHK. Called by main setup.
 void loopAHK(); ///< Handle the AHK. Called from main loop to run the HK.
+void ahkBegin(); ///< Hold light and servo changes so coincident cues land together.
+void ahkCommit(); ///< Make every change held since ahkBegin().
 
 bool isTailLights(); ///< Tail lights on/off.
 void tailLightsOn(); ///< Tail lights on.
@@ -47,16 +49,22 @@ bool isPlasmaGun(); ///< Plasma gun firing/not.
 void plasmaGunOn(); ///< Start firing.
 void plasmaGunOff(); ///< Stop firing.
 
+void thrustTo(int thrust, int speed = AHK_THRUST_SPEED); ///< Both thrusters to an angle.
+
 int getTilt();
+void tiltTo(int degrees); ///< Tilt to an angle, limited to AHK_TILT_MIN-AHK_TILT_MAX.
 void tiltForward();
 void tiltLevel();
 void tiltBackward();
+void tiltDive(); ///< Dip forward and back to level along a curve, from level.
 
 int getTurn();
+void turnTo(int degrees, int speed = AHK_TURN_SPEED); ///< Turn to an angle, limited to AHK_TURN_MIN-AHK_TURN_MAX.
 void turnLeft();
 void turnCentre();
 void turnRight();
 void turnRightRandom();
+void turnScan(); ///< Sweep right then left and back to centre along a curve, from centre.
 
 void thrustMin(); ///< Thrust to minimum setting.
 void thrustBack(); ///< Thrust backwards.
@@ -66,4 +74,8 @@ void thrustMax(); ///< Thrust to maximum forward.
 void thrustLeft(); ///< Thrust left. One thruster backwards, the other forwards.
 void thrustRight(); ///< Thrust right. One thruster forwards, the other backwards.
 
+int thrustTrim(int delta); ///< Move the thrust centre by delta degrees and save it. Returns the new trim.
+int tiltTrim(int delta); ///< Move the tilt servo's centre by delta degrees and save it. Returns the new trim.
+int turnTrim(int delta); ///< Move the turn servo's centre by delta degrees and save it. Returns the new trim.
+
 #endif /* INCLUDED_AERIALHK_H */
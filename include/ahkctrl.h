@@ -12,5 +12,9 @@
 
 void setupAHKCtrl(); ///< Setup controller.
 void loopAHKCtrl(); ///< Handle AHK Controls.
+bool ctrlNextDue(unsigned long &due); ///< millis() loopAHKCtrl() next has work, false if none is pending.
+
+void startTurnRightRandom(); ///< Pan right in random steps until stopped.
+void stopTurning(); ///< Stop random panning.
 
 #endif /* INCLUDED_AHKCTRL_H */
@@ -0,0 +1,369 @@
+/**
+ * @file ahkcue.h
+ * @author John Scott
+ * @brief Packed cue tables, built and validated from AsyncTiming lists at compile time.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ *
+ * Each cue packs into PROGMEM as:
+ *
+ *   [repeat flag | arg flag | action index] [start delta varint] [repeat varint, if flagged] [arg, if flagged]
+ *
+ * The action index selects from CUE_ACTIONS, the delta is milliseconds since
+ * the previous cue, and varints hold 7 bits per byte, low bits first, with the
+ * top bit set on all but the last byte. An action index of CUE_END ends the
+ * table. A typical cue takes 2-3 bytes rather than the 11 of an AsyncTiming.
+ * Arguments run 1-255, 0 meaning none.
+ *
+ * Cues may be written in any order, they are sorted by start time (equal
+ * times keep their order) as they are packed. CUE_INFO, parallel to
+ * CUE_ACTIONS, names the actuators each action drives and the range of its
+ * argument. A list fails to compile if two different cues drive an actuator
+ * within CUE_WINDOW ms of each other, if an argument is out of range or given
+ * to an action that takes none, or if a cue with an argument repeats. The
+ * failing cue's start time is shown as CueConflictAt<ms> or CueBadArgAt<ms> in
+ * the compiler's error.
+ *
+ * PACK_KEYFRAMES indexes a table for seeking. Every CUE_KEYFRAME ms it keeps
+ * a snapshot: the latest cue before that time for each actuator, and every
+ * repeating cue started by then, packed as a cue table. A seek loads the
+ * snapshot before the target and reads on in the table from there, so it
+ * reads at most CUE_KEYFRAME ms of cues whatever the target. The index is:
+ *
+ *   [keyframe count] [offset of each keyframe, 2 bytes low first]
+ *
+ * then for each keyframe:
+ *
+ *   [offset in the table of its first cue varint] [start of the cue before that varint] [snapshot cues] [CUE_END]
+ */
+#ifndef INCLUDED_AHKCUE_H
+#define INCLUDED_AHKCUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ahktimeline.h"
+
+#define CUE_ACTION_MASK 0x3F ///< Action index bits of a cue's first byte.
+#define CUE_ARG 0x40 ///< Argument byte follows.
+#define CUE_REPEAT 0x80 ///< Repeat interval follows the start delta.
+#define CUE_END 0x3F ///< Action index marking the end of a table.
+#define CUE_WINDOW 50 ///< Milliseconds that must separate different cues on one actuator.
+#define CUE_KEYFRAME 10000 ///< Milliseconds between keyframes.
+
+typedef void (*CueAction)();
+
+extern const CueAction CUE_ACTIONS[]; ///< PROGMEM actions cues can call, indexed by cue.
+extern const unsigned char CUE_ACTION_COUNT; ///< Entries in CUE_ACTIONS.
+
+struct CueInfo {
+  unsigned short actuators; ///< Bits for what the action drives, cues sharing a bit conflict.
+  unsigned char argMin; ///< Lowest argument.
+  unsigned char argMax; ///< Highest argument, 0 if the action takes none.
+};
+
+extern const struct CueInfo CUE_INFO[]; ///< PROGMEM, what each of CUE_ACTIONS drives.
+
+#define CUE_DRIVES(ACTUATORS) {ACTUATORS, 0, 0} ///< CueInfo for an action without an argument.
+#define CUE_DRIVES_TO(ACTUATORS, MIN, MAX) {ACTUATORS, MIN, MAX} ///< CueInfo for an action taking MIN to MAX.
+
+struct CueReader {
+  const uint8_t *next; ///< Next PROGMEM byte.
+  unsigned long start; ///< Start time of the last cue read.
+  unsigned char action; ///< CUE_ACTIONS index of the last cue read.
+};
+
+void cueBegin(struct CueReader &reader, const uint8_t cues[]); ///< Read a packed table from the start.
+bool cueRead(struct CueReader &reader, struct AsyncTiming &cue); ///< Next cue, or false at the end.
+void cueSeek(struct CueReader &snapshot, struct CueReader &table, const uint8_t cues[], const uint8_t keys[], unsigned long position); ///< Read the snapshot at or before position from the PROGMEM index keys (or 0), then table from there.
+
+
+//
+// Compile-time builder...
+//
+template<size_t N>
+struct PackedCues {
+  uint8_t bytes[N];
+};
+
+template<size_t N>
+struct CueList {
+  struct AsyncTiming cues[N];
+  size_t count; ///< Cues before END_TIMINGS.
+};
+
+// MS is the start of the first bad cue or -1, named in the compiler's error.
+template<long MS>
+struct CueConflictAt {
+  static_assert(MS < 0, "Cue drives an actuator another cue drove less than CUE_WINDOW ms before");
+  static constexpr bool ok = MS < 0;
+};
+
+template<long MS>
+struct CueBadArgAt {
+  static_assert(MS < 0, "Cue argument out of range, given to an action taking none, or repeating");
+  static constexpr bool ok = MS < 0;
+};
+
+template<size_t N>
+constexpr CueList<N> sortCues(const struct AsyncTiming (&timings)[N]) {
+  CueList<N> list = {};
+
+  while(list.count < N && timings[list.count].callback) {
+    struct AsyncTiming cue = timings[list.count];
+    size_t i = list.count++;
+
+    for(; i && list.cues[i - 1].start > cue.start; --i) {
+      list.cues[i] = list.cues[i - 1];
+    }
+    list.cues[i] = cue;
+  }
+  return list;
+}
+
+constexpr size_t cueVarintSize(unsigned long value) {
+  size_t size = 1;
+  while(value >= 0x80) {
+    value >>= 7;
+    ++size;
+  }
+  return size;
+}
+
+template<size_t A>
+constexpr int cueActionIndex(const CueAction (&actions)[A], CueAction callback) {
+  for(size_t i = 0; i < A; ++i) {
+    if(actions[i] == callback) {
+      return (int)i;
+    }
+  }
+  return -1;
+}
+
+template<size_t A, size_t N>
+constexpr bool cuesKnown(const CueAction (&actions)[A], const struct AsyncTiming (&timings)[N]) {
+  if(A >= CUE_END) {
+    return false;
+  }
+
+  for(size_t i = 0; i < N && timings[i].callback; ++i) {
+    if(cueActionIndex(actions, timings[i].callback) < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Start of the first cue with a bad argument, or -1.
+template<size_t A, size_t N>
+constexpr long cueBadArg(const CueAction (&actions)[A], const struct CueInfo (&info)[A], const CueList<N> &list) {
+  for(size_t i = 0; i < list.count; ++i) {
+    const struct AsyncTiming &cue = list.cues[i];
+    const struct CueInfo &action = info[cueActionIndex(actions, cue.callback)];
+
+    if(action.argMax ? cue.repeat || cue.arg < action.argMin || cue.arg > action.argMax : cue.arg != 0) {
+      return (long)cue.start;
+    }
+  }
+  return -1;
+}
+
+// Start of the first cue driving an actuator another cue drove less than
+// CUE_WINDOW ms before, or -1. Repeats of the same cue are not conflicts.
+template<size_t A, size_t N>
+constexpr long cueConflict(const CueAction (&actions)[A], const struct CueInfo (&info)[A], const CueList<N> &list) {
+  for(size_t j = 1; j < list.count; ++j) {
+    const struct AsyncTiming &later = list.cues[j];
+    unsigned short drives = info[cueActionIndex(actions, later.callback)].actuators;
+
+    for(size_t i = j; i-- > 0 && later.start - list.cues[i].start < CUE_WINDOW;) {
+      const struct AsyncTiming &earlier = list.cues[i];
+      bool same = earlier.callback == later.callback && earlier.arg == later.arg;
+
+      if(!same && (info[cueActionIndex(actions, earlier.callback)].actuators & drives)) {
+        return (long)later.start;
+      }
+    }
+  }
+  return -1;
+}
+
+// Same action and argument at the same time as the cue before, packed once.
+template<size_t N>
+constexpr bool cueDuplicate(const CueList<N> &list, size_t i) {
+  for(size_t d = i; d-- > 0 && list.cues[d].start == list.cues[i].start;) {
+    if(list.cues[d].callback == list.cues[i].callback && list.cues[d].arg == list.cues[i].arg && list.cues[d].repeat == list.cues[i].repeat) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Bytes packing the first end cues takes, without CUE_END.
+template<size_t N>
+constexpr size_t cuesSize(const CueList<N> &list, size_t end) {
+  size_t size = 0;
+  unsigned long start = 0;
+
+  for(size_t i = 0; i < end; ++i) {
+    const struct AsyncTiming &cue = list.cues[i];
+    if(cueDuplicate(list, i)) {
+      continue;
+    }
+
+    size += 1 + cueVarintSize(cue.start - start) + (cue.arg ? 1 : 0);
+    if(cue.repeat) {
+      size += cueVarintSize(cue.repeat);
+    }
+    start = cue.start;
+  }
+  return size;
+}
+
+template<size_t N>
+constexpr size_t packedCuesSize(const CueList<N> &list) {
+  return cuesSize(list, list.count) + 1; // CUE_END
+}
+
+template<size_t S>
+constexpr size_t cuePutVarint(PackedCues<S> &packed, size_t at, unsigned long value) {
+  while(value >= 0x80) {
+    packed.bytes[at++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  packed.bytes[at++] = (uint8_t)value;
+  return at;
+}
+
+// Pack list at byte at, ending with CUE_END. Returns the byte after.
+template<size_t S, size_t A, size_t N>
+constexpr size_t cuePutCues(PackedCues<S> &packed, size_t at, const CueAction (&actions)[A], const CueList<N> &list) {
+  unsigned long start = 0;
+
+  for(size_t i = 0; i < list.count; ++i) {
+    const struct AsyncTiming &cue = list.cues[i];
+    if(cueDuplicate(list, i)) {
+      continue;
+    }
+
+    packed.bytes[at++] = (uint8_t)(cueActionIndex(actions, cue.callback) | (cue.repeat ? CUE_REPEAT : 0) | (cue.arg ? CUE_ARG : 0));
+    at = cuePutVarint(packed, at, cue.start - start);
+    if(cue.repeat) {
+      at = cuePutVarint(packed, at, cue.repeat);
+    }
+    if(cue.arg) {
+      packed.bytes[at++] = cue.arg;
+    }
+    start = cue.start;
+  }
+  packed.bytes[at++] = CUE_END;
+  return at;
+}
+
+template<size_t S, size_t A, size_t N>
+constexpr PackedCues<S> packCues(const CueAction (&actions)[A], const CueList<N> &list) {
+  PackedCues<S> packed = {};
+  cuePutCues(packed, 0, actions, list);
+  return packed;
+}
+
+
+//
+// Compile-time keyframe index builder...
+//
+template<size_t N>
+constexpr size_t cueKeyframes(const CueList<N> &list) {
+  return list.count ? list.cues[list.count - 1].start / CUE_KEYFRAME : 0;
+}
+
+// Index of the first cue starting at or after ms, list.count if none.
+template<size_t N>
+constexpr size_t cueFirstAt(const CueList<N> &list, unsigned long ms) {
+  size_t i = 0;
+  while(i < list.count && list.cues[i].start < ms) {
+    ++i;
+  }
+  return i;
+}
+
+// The first end cues that still matter after them: the latest for an
+// actuator, and repeating cues.
+template<size_t A, size_t N>
+constexpr CueList<N> cueSnapshot(const CueAction (&actions)[A], const struct CueInfo (&info)[A], const CueList<N> &list, size_t end) {
+  CueList<N> snapshot = {};
+  bool keep[N] = {};
+  unsigned short covered = 0;
+
+  for(size_t i = end; i-- > 0;) {
+    if(cueDuplicate(list, i)) {
+      continue;
+    }
+    unsigned short drives = info[cueActionIndex(actions, list.cues[i].callback)].actuators;
+    keep[i] = list.cues[i].repeat || (drives & ~covered);
+    covered |= drives;
+  }
+
+  for(size_t i = 0; i < end; ++i) {
+    if(keep[i]) {
+      snapshot.cues[snapshot.count++] = list.cues[i];
+    }
+  }
+  return snapshot;
+}
+
+template<size_t A, size_t N>
+constexpr size_t packedKeyframesSize(const CueAction (&actions)[A], const struct CueInfo (&info)[A], const CueList<N> &list) {
+  size_t keys = cueKeyframes(list);
+  size_t size = 1 + 2 * keys;
+
+  for(size_t k = 1; k <= keys; ++k) {
+    size_t first = cueFirstAt(list, k * CUE_KEYFRAME);
+    size += cueVarintSize(cuesSize(list, first)) + cueVarintSize(first ? list.cues[first - 1].start : 0);
+    size += packedCuesSize(cueSnapshot(actions, info, list, first));
+  }
+  return size;
+}
+
+template<size_t S, size_t A, size_t N>
+constexpr PackedCues<S> packKeyframes(const CueAction (&actions)[A], const struct CueInfo (&info)[A], const CueList<N> &list) {
+  PackedCues<S> packed = {};
+  size_t keys = cueKeyframes(list);
+  size_t at = 1 + 2 * keys;
+
+  packed.bytes[0] = (uint8_t)keys;
+  for(size_t k = 1; k <= keys; ++k) {
+    size_t first = cueFirstAt(list, k * CUE_KEYFRAME);
+
+    packed.bytes[2 * k - 1] = (uint8_t)at;
+    packed.bytes[2 * k] = (uint8_t)(at >> 8);
+    at = cuePutVarint(packed, at, cuesSize(list, first));
+    at = cuePutVarint(packed, at, first ? list.cues[first - 1].start : 0);
+    at = cuePutCues(packed, at, actions, cueSnapshot(actions, info, list, first));
+  }
+  return packed;
+}
+
+/**
+ * Define NAME as a PROGMEM packed, time sorted copy of the constexpr
+ * AsyncTiming list TIMINGS, checking at compile time that every action is in
+ * CUE_ACTIONS and that no cue breaks the rules in CUE_INFO. Pass NAME.bytes
+ * to the timeline.
+ */
+#define PACK_CUES(NAME, TIMINGS) \
+  static_assert(cuesKnown(CUE_ACTIONS, TIMINGS), #TIMINGS " calls an action missing from CUE_ACTIONS"); \
+  static_assert(CueBadArgAt<cueBadArg(CUE_ACTIONS, CUE_INFO, sortCues(TIMINGS))>::ok, #TIMINGS " has a bad argument"); \
+  static_assert(CueConflictAt<cueConflict(CUE_ACTIONS, CUE_INFO, sortCues(TIMINGS))>::ok, #TIMINGS " has conflicting cues"); \
+  static constexpr PackedCues<packedCuesSize(sortCues(TIMINGS))> NAME PROGMEM = \
+    packCues<packedCuesSize(sortCues(TIMINGS))>(CUE_ACTIONS, sortCues(TIMINGS))
+
+/**
+ * Define NAME as the PROGMEM keyframe index of the list TIMINGS, packed with
+ * PACK_CUES(). Pass NAME.bytes to the timeline with the table.
+ */
+#define PACK_KEYFRAMES(NAME, TIMINGS) \
+  static_assert(cueKeyframes(sortCues(TIMINGS)) <= 255, #TIMINGS " needs more than 255 keyframes"); \
+  static constexpr PackedCues<packedKeyframesSize(CUE_ACTIONS, CUE_INFO, sortCues(TIMINGS))> NAME PROGMEM = \
+    packKeyframes<packedKeyframesSize(CUE_ACTIONS, CUE_INFO, sortCues(TIMINGS))>(CUE_ACTIONS, CUE_INFO, sortCues(TIMINGS))
+
+#endif /* INCLUDED_AHKCUE_H */
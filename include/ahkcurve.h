@@ -0,0 +1,132 @@
+/**
+ * @file ahkcurve.h
+ * @author John Scott
+ * @brief Servo motion curves, keyframe splines sampled into PROGMEM tables at compile time.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ *
+ * A curve is a list of keyframes, each an angle at a time from the start. The
+ * compiler fits a cubic Hermite spline through them, smooth through every key,
+ * easing in and out at the ends and never overshooting a turning point, and
+ * packs it into PROGMEM as:
+ *
+ *   [step ms] [sample count, low byte] [sample count, high byte] [degrees]...
+ *
+ * with one angle every step milliseconds. Playback (see ahkmotion.h) looks up
+ * the two samples either side of now and interpolates between them in integer
+ * maths, so a curve costs the same to play however many keys it has.
+ */
+#ifndef INCLUDED_AHKCURVE_H
+#define INCLUDED_AHKCURVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CURVE_HEADER 3 ///< Bytes before the samples.
+
+struct CurveKey {
+  unsigned short ms; ///< Time from the start of the curve.
+  unsigned char degrees; ///< Servo angle at that time.
+};
+
+
+//
+// Compile-time builder...
+//
+template<size_t N>
+struct PackedCurve {
+  uint8_t bytes[N];
+};
+
+template<size_t K>
+constexpr size_t curveSamples(const struct CurveKey (&keys)[K], uint8_t step) {
+  return (keys[K - 1].ms + step - 1) / step + 1;
+}
+
+template<size_t K>
+constexpr bool curveKeysValid(const struct CurveKey (&keys)[K]) {
+  if(K < 2 || keys[0].ms) {
+    return false;
+  }
+
+  for(size_t i = 0; i < K; ++i) {
+    if(keys[i].degrees > 180 || (i && keys[i].ms <= keys[i - 1].ms)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Slope at a key in degrees per ms. Level at the ends so the curve eases in and
+// out, and at turning points so it never swings past a key.
+template<size_t K>
+constexpr double curveSlope(const struct CurveKey (&keys)[K], size_t i) {
+  if(i == 0 || i == K - 1) {
+    return 0;
+  }
+
+  int in = (int)keys[i].degrees - keys[i - 1].degrees;
+  int out = (int)keys[i + 1].degrees - keys[i].degrees;
+  if((in < 0) != (out < 0) || !in || !out) {
+    return 0;
+  }
+
+  double slope = ((double)keys[i + 1].degrees - keys[i - 1].degrees) / (keys[i + 1].ms - keys[i - 1].ms);
+  double before = (double)in / (keys[i].ms - keys[i - 1].ms);
+  double after = (double)out / (keys[i + 1].ms - keys[i].ms);
+  double limit = 3 * (before * before < after * after ? before : after); // Fritsch-Carlson, keeps each span monotonic.
+
+  return slope * slope > limit * limit ? limit : slope;
+}
+
+template<size_t K>
+constexpr uint8_t curveAt(const struct CurveKey (&keys)[K], unsigned long ms) {
+  size_t i = 0;
+  while(i + 2 < K && ms > keys[i + 1].ms) {
+    ++i;
+  }
+
+  if(ms >= keys[K - 1].ms) {
+    return keys[K - 1].degrees;
+  }
+
+  double span = keys[i + 1].ms - keys[i].ms;
+  double t = (ms - keys[i].ms) / span;
+  double t2 = t * t;
+  double t3 = t2 * t;
+  double degrees = (2 * t3 - 3 * t2 + 1) * keys[i].degrees
+    + (t3 - 2 * t2 + t) * span * curveSlope(keys, i)
+    + (-2 * t3 + 3 * t2) * keys[i + 1].degrees
+    + (t3 - t2) * span * curveSlope(keys, i + 1);
+
+  return degrees <= 0 ? 0 : degrees >= 180 ? 180 : (uint8_t)(degrees + 0.5);
+}
+
+template<size_t S, size_t K>
+constexpr PackedCurve<S> bakeCurve(const struct CurveKey (&keys)[K], uint8_t step) {
+  PackedCurve<S> packed = {};
+  size_t samples = S - CURVE_HEADER;
+
+  packed.bytes[0] = step;
+  packed.bytes[1] = (uint8_t)samples;
+  packed.bytes[2] = (uint8_t)(samples >> 8);
+  for(size_t i = 0; i < samples; ++i) {
+    packed.bytes[CURVE_HEADER + i] = curveAt(keys, (unsigned long)i * step);
+  }
+  return packed;
+}
+
+/**
+ * Define NAME as a PROGMEM curve through the constexpr CurveKey list KEYS,
+ * sampled every STEP ms. Keys must start at 0 ms, run forward in time and stay
+ * within 0-180 degrees. Pass NAME.bytes to motionCurve().
+ */
+#define BAKE_CURVE(NAME, STEP, KEYS) \
+  static_assert(curveKeysValid(KEYS), #KEYS " must start at 0 ms, go forward in time and stay within 0-180 degrees"); \
+  static_assert((STEP) > 0 && (STEP) < 256, #NAME " step must be 1-255 ms"); \
+  static constexpr PackedCurve<CURVE_HEADER + curveSamples(KEYS, STEP)> NAME PROGMEM = \
+    bakeCurve<CURVE_HEADER + curveSamples(KEYS, STEP)>(KEYS, STEP)
+
+#endif /* INCLUDED_AHKCURVE_H */
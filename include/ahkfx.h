@@ -10,6 +10,10 @@
 #ifndef INCLUDED_AHKFX_H
 #define INCLUDED_AHKFX_H
 
+#define VOL_MIN 0
+#define VOL_CENTRE 15
+#define VOL_MAX 30
+
 void setupAHKEffects();
 void loopAHKEffects();
 
@@ -30,5 +34,12 @@ void playFlyMore();
 void playLanding();
 void playScene01();
 void stopPlaying();
+void pauseSound(); ///< Pause the track playing.
+void resumeSound(); ///< Play on from where the track was paused.
+void seekSound(unsigned short seconds); ///< Play the track from seconds in, resuming it if paused.
+
+bool isSoundStarting(); ///< Play, resume and seek commands still waiting for the DFPlayer to acknowledge them.
+bool soundStartedAt(unsigned long &at); ///< millis() the last play command was acknowledged. False if it was given up on instead.
+bool soundNextDue(unsigned long &due); ///< millis() the sound queue next needs the loop, false if it is empty.
 
 #endif /* INCLUDED_AHKFX_H */
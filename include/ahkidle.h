@@ -0,0 +1,24 @@
+/**
+ * @file ahkidle.h
+ * @author John Scott
+ * @brief Idle sleep between events, and the measured duty cycle for battery estimates.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_AHKIDLE_H
+#define INCLUDED_AHKIDLE_H
+
+struct IdleStats {
+  unsigned long since; ///< millis() counting started.
+  unsigned long asleep; ///< Milliseconds asleep since then.
+  unsigned long sleeps; ///< Times the CPU went to sleep.
+};
+
+void setupAHKIdle(); ///< Turn off unused peripherals. After setup has finished with them.
+void loopAHKIdle(); ///< Sleep until the next deadline or input. Last in loop().
+const struct IdleStats &idleStats(); ///< Sleep counters.
+void idleReset(); ///< Restart the counters.
+
+#endif /* INCLUDED_AHKIDLE_H */
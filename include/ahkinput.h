@@ -0,0 +1,34 @@
+/**
+ * @file ahkinput.h
+ * @author John Scott
+ * @brief Single-producer/single-consumer ring of decoded control commands.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_AHKINPUT_H
+#define INCLUDED_AHKINPUT_H
+
+#define INPUT_QUEUE_SIZE 16 ///< Commands held between loop passes (power of 2, at most 128).
+
+struct InputEvent {
+  char cmd; ///< One of the CTL_* commands.
+  unsigned long received; ///< micros() when queued.
+};
+
+struct InputStats {
+  unsigned long events; ///< Commands handled.
+  unsigned long maxLatency; ///< Slowest key-to-action time (us).
+  unsigned long totalLatency; ///< Sum of key-to-action times, for the mean.
+  unsigned short overflows; ///< Commands lost because the ring was full.
+  unsigned char highWater; ///< Most commands queued at once.
+};
+
+bool inputPush(char cmd); ///< Producer side. Safe from one interrupt handler or the main loop.
+bool inputPop(struct InputEvent &event); ///< Consumer side, main loop only.
+bool inputPending(); ///< Commands waiting to be popped.
+void inputDone(const struct InputEvent &event); ///< Record key-to-action latency once handled.
+const struct InputStats &inputStats(); ///< Throughput, latency and overflow counters.
+
+#endif /* INCLUDED_AHKINPUT_H */
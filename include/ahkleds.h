@@ -0,0 +1,48 @@
+/**
+ * @file ahkleds.h
+ * @author John Scott
+ * @brief LED effect pool. Owns every JLed effect and steps the running ones together.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ *
+ * Pool effects are JLed objects whose HAL records each brightness rather than
+ * writing the pin, and whose clock is the pool's. ledsUpdate() reads millis()
+ * once, steps each running effect at that time, then drives the pins that
+ * changed: on/off pins in one write per port (see ahkout.h), PWM pins with
+ * analogWrite(). An effect that has ended, including a steady On() or Off()
+ * once set, costs nothing until it is started again.
+ *
+ * To add a LED, add its output to ahkout.h and to LED_OUTPUTS and LED_PINS.
+ */
+#ifndef INCLUDED_AHKLEDS_H
+#define INCLUDED_AHKLEDS_H
+
+#include <jled.h>
+
+#define LED_COUNT 4 ///< Outputs driven by effects (at most 8).
+
+extern uint32_t ledsNow; ///< Time of the current pass, the clock every effect reads.
+
+class LedHal {
+ public:
+  using PinType = uint8_t; ///< Pool slot rather than a pin.
+  explicit LedHal(PinType slot) : slot_(slot) {}
+  void analogWrite(uint8_t brightness) const; ///< Record the brightness for ledsUpdate() to drive.
+  uint32_t millis() const { return ledsNow; }
+
+ private:
+  PinType slot_;
+};
+
+class PoolLed : public jled::TJLed<LedHal, PoolLed> {
+ public:
+  using jled::TJLed<LedHal, PoolLed>::TJLed;
+};
+
+PoolLed &ledEffect(unsigned char output); ///< Reset and mark running the effect on an OUT_* output, to chain an effect onto.
+unsigned char ledsUpdate(); ///< Step every running effect and drive their pins. OUT_* bits of the effects that ended.
+bool ledsNextDue(unsigned long &due); ///< millis() of the next step, false if no effect is running.
+
+#endif /* INCLUDED_AHKLEDS_H */
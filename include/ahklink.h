@@ -0,0 +1,48 @@
+/**
+ * @file ahklink.h
+ * @author John Scott
+ * @brief Live control from a host over the console, in framed batches of actions.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ *
+ * A frame is:
+ *
+ *   [LINK_MARK] [sequence] [length] [commands, length bytes] [CRC-8 of sequence to commands]
+ *
+ * and each command is a cue without its timing:
+ *
+ *   [arg flag | action index] [arg, if flagged]
+ *
+ * indexing CUE_ACTIONS and checked against CUE_INFO as cues are. The
+ * commands of a frame are made together in one loop pass, as coincident cues
+ * are, so "tilt to 150, turn to 60, blue flash, thrust right" lands at once.
+ * A frame driving an actuator twice is refused.
+ *
+ * Frames are read a byte at a time as they arrive among the console's
+ * single character commands, which never contain LINK_MARK. Each good frame
+ * is answered with "Link ack <sequence>" in the log, a refused one with
+ * "Link nak <sequence>", and a damaged one not at all. The host sends the
+ * next frame with the next sequence, or sends a frame again with the same
+ * sequence if no answer comes: a repeat is acknowledged without being made
+ * twice. Sequences run 1-255 after a first frame of 0, which is never a
+ * repeat, so a host can start afresh. A frame that stops for LINK_GAP ms is
+ * dropped. The bytes of a dropped, damaged or too long frame are never taken
+ * as key commands: the rest of a too long frame is skipped by its length,
+ * otherwise bytes are skipped until the console is quiet for LINK_GAP ms or,
+ * after a gap, a new frame starts.
+ * tools/ahklink.py sends commands this way.
+ */
+#ifndef INCLUDED_AHKLINK_H
+#define INCLUDED_AHKLINK_H
+
+#define LINK_MARK 0x02 ///< First byte of a frame.
+#define LINK_COMMANDS_MAX 32 ///< Bytes of commands a frame can carry.
+#define LINK_GAP 100 ///< Milliseconds between bytes that abandon a frame.
+
+bool linkByte(int b); ///< Take a console byte, false if it isn't part of a frame.
+bool linkPending(); ///< A frame is waiting for linkApply().
+void linkApply(); ///< Make the waiting frame's commands and acknowledge it.
+
+#endif /* INCLUDED_AHKLINK_H */
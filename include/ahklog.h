@@ -0,0 +1,142 @@
+/**
+ * @file ahklog.h
+ * @author John Scott
+ * @brief Console log. Messages are recorded as small binary frames in a ring
+ * and sent only when the serial port has room, so logging never blocks the loop.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ *
+ * Every message is listed once in LOG_MESSAGES with its severity, rate limit
+ * and format. A frame on the wire is:
+ *
+ *   [LOG_MARK] [id] [argument count | LOG_SUPPRESSED] [ms since the last frame varint]
+ *   [arguments, zigzag varints] [repeats suppressed varint, if flagged]
+ *
+ * with varints as ahkcue.h. After LOG_MARK, a LOG_MARK or LOG_ESC byte is
+ * sent as LOG_ESC then the byte ^ LOG_ESC_FLIP, so LOG_MARK only ever starts a
+ * frame. The console carries text too (the banner and the stats dump), which
+ * never contains LOG_MARK. A decoder joining part way, or losing bytes, finds
+ * the next frame at the next LOG_MARK. tools/ahklog.py reads this
+ * header for the formats and turns a captured or live console back into
+ * text. Formats take %d (signed), %u (unsigned), %x (hex), %c4 (up to four
+ * characters packed low byte first) and %S (a scene number, shown with its
+ * name from SCENES, which the decoder reads from src/ahkscenes.cpp).
+ *
+ * Messages below AHK_LOG_LEVEL compile to nothing. A message with a rate
+ * limit is recorded at most once per limit, and the next one recorded counts
+ * those suppressed in between. If the ring is full the message is dropped
+ * and LOG_DROPPED reports how many once there is room. Build with
+ * -DAHK_LOG_TEXT to send the formatted text instead, for a plain serial
+ * monitor.
+ */
+#ifndef INCLUDED_AHKLOG_H
+#define INCLUDED_AHKLOG_H
+
+#define LOG_DEBUG 0 ///< Timing detail.
+#define LOG_INFO 1 ///< What the unit is doing.
+#define LOG_WARN 2 ///< Something was lost or refused.
+#define LOG_ERROR 3 ///< A peripheral failed.
+
+#ifndef AHK_LOG_LEVEL
+#define AHK_LOG_LEVEL LOG_INFO ///< Lowest severity built in.
+#endif
+
+#define LOG_MARK 0x1E ///< First byte of a frame.
+#define LOG_ESC 0x1D ///< Escapes a LOG_MARK or LOG_ESC byte within a frame.
+#define LOG_ESC_FLIP 0x20 ///< Flipped in an escaped byte.
+#define LOG_SUPPRESSED 0x80 ///< Frame ends with the count of rate limited repeats.
+#define LOG_ARGS_MAX 2 ///< Arguments a message can carry.
+
+// M(ID, SEVERITY, RATE LIMIT ms, FORMAT). Append new messages, decoders index by position.
+#define LOG_MESSAGES(M) \
+  M(LOG_DROPPED, LOG_WARN, 0, "Log dropped %u messages") \
+  M(LOG_POWER_ON, LOG_INFO, 0, "Power on") \
+  M(LOG_POWER_OFF, LOG_INFO, 0, "Power off") \
+  M(LOG_LEVEL_OFF, LOG_INFO, 0, "Levelling off") \
+  M(LOG_BANK_LEFT, LOG_INFO, 0, "Bank left") \
+  M(LOG_BANK_RIGHT, LOG_INFO, 0, "Bank right") \
+  M(LOG_HOVER, LOG_INFO, 0, "Hover") \
+  M(LOG_FLY_FORWARD, LOG_INFO, 0, "Fly forward") \
+  M(LOG_PURSUIT, LOG_INFO, 0, "Pursuite Mode") \
+  M(LOG_LANDING_OFF, LOG_INFO, 0, "Landing lights deactivate") \
+  M(LOG_LANDING_ON, LOG_INFO, 0, "Landing lights activate") \
+  M(LOG_CEASE_FIRE, LOG_INFO, 0, "Cease fire") \
+  M(LOG_FIRING, LOG_INFO, 0, "Commence firing") \
+  M(LOG_SEARCH_OFF, LOG_INFO, 0, "Suspend search mode") \
+  M(LOG_SEARCH_ON, LOG_INFO, 0, "Search mode activated") \
+  M(LOG_SCENE, LOG_INFO, 0, "Scene %S") \
+  M(LOG_THRUST_TRIM, LOG_INFO, 0, "Thrust trim %d") \
+  M(LOG_TILT_TRIM, LOG_INFO, 0, "Tilt trim %d") \
+  M(LOG_TURN_TRIM, LOG_INFO, 0, "Turn trim %d") \
+  M(LOG_SOUND_SYNC, LOG_INFO, 0, "Sound sync %u ms") \
+  M(LOG_SOUND_SYNC_FAILED, LOG_WARN, 0, "Sound sync failed after %u ms") \
+  M(LOG_IR_ERROR, LOG_WARN, 1000, "IR Code Error: %x") \
+  M(LOG_SFX_FULL, LOG_WARN, 1000, "SFX Queue Full") \
+  M(LOG_SFX_ERROR, LOG_ERROR, 0, "SFX Receive Error: %c4") \
+  M(LOG_SFX_TIMEOUT, LOG_ERROR, 0, "SFX Timeout: %c4") \
+  M(LOG_MOTION_FULL, LOG_WARN, 1000, "Motion Group Full") \
+  M(LOG_SCHED_FULL, LOG_WARN, 1000, "Scheduler Full") \
+  M(LOG_CUE_LATE, LOG_DEBUG, 0, "Cue %u late %u") \
+  M(LOG_SCENE_PAUSE, LOG_INFO, 0, "Scene paused at %u ms") \
+  M(LOG_SCENE_RESUME, LOG_INFO, 0, "Scene resumed at %u ms") \
+  M(LOG_SCENE_SEEK, LOG_INFO, 0, "Scene seek to %u ms") \
+  M(LOG_STREAM_WANT, LOG_INFO, 0, "Stream want %u") \
+  M(LOG_STREAM_DONE, LOG_INFO, 0, "Stream ended after %u bytes") \
+  M(LOG_STREAM_STOP, LOG_WARN, 0, "Stream stopped at byte %u") \
+  M(LOG_STREAM_ERROR, LOG_ERROR, 0, "Stream error at byte %u") \
+  M(LOG_STREAM_TIMEOUT, LOG_ERROR, 0, "Stream timed out at byte %u") \
+  M(LOG_LINK_ACK, LOG_INFO, 0, "Link ack %u") \
+  M(LOG_LINK_NAK, LOG_WARN, 0, "Link nak %u") \
+  M(LOG_LINK_CRC, LOG_WARN, 1000, "Link CRC error")
+
+#define LOG_ID(ID, SEVERITY, RATE, FORMAT) ID,
+enum LogId : unsigned char {
+  LOG_MESSAGES(LOG_ID)
+  LOG_COUNT
+};
+#undef LOG_ID
+
+#define LOG_SEVERITY(ID, SEVERITY, RATE, FORMAT) SEVERITY,
+constexpr signed char LOG_SEVERITIES[] = {LOG_MESSAGES(LOG_SEVERITY)};
+#undef LOG_SEVERITY
+
+#define LOG_RATE(ID, SEVERITY, RATE, FORMAT) RATE,
+constexpr unsigned short LOG_RATES[] = {LOG_MESSAGES(LOG_RATE)};
+#undef LOG_RATE
+
+// Rate limited messages before id, its slot for the time it was last recorded.
+constexpr unsigned char logRateSlot(unsigned char id) {
+  unsigned char slot = 0;
+  for(unsigned char i = 0; i < id; ++i) {
+    slot += LOG_RATES[i] != 0;
+  }
+  return slot;
+}
+
+void loopAHKLog(); ///< Send whole frames while the serial port has room.
+bool logNextDue(unsigned long &due); ///< millis() to look for room again, false if the ring is empty.
+void logRecord(unsigned char id, unsigned char count, long arg0, long arg1); ///< Use logEvent().
+long logChars(const char *text); ///< Pack the first four characters of text for %c4.
+
+// Record a message, if its severity is built in.
+static inline void logEvent(enum LogId id) {
+  if(LOG_SEVERITIES[id] >= AHK_LOG_LEVEL) {
+    logRecord(id, 0, 0, 0);
+  }
+}
+
+static inline void logEvent(enum LogId id, long arg0) {
+  if(LOG_SEVERITIES[id] >= AHK_LOG_LEVEL) {
+    logRecord(id, 1, arg0, 0);
+  }
+}
+
+static inline void logEvent(enum LogId id, long arg0, long arg1) {
+  if(LOG_SEVERITIES[id] >= AHK_LOG_LEVEL) {
+    logRecord(id, 2, arg0, arg1);
+  }
+}
+
+#endif /* INCLUDED_AHKLOG_H */
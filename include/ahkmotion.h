@@ -0,0 +1,25 @@
+/**
+ * @file ahkmotion.h
+ * @author John Scott
+ * @brief Motion groups, servo moves planned so every servo in the group arrives together, and curve playback.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_AHKMOTION_H
+#define INCLUDED_AHKMOTION_H
+
+#include <ServoEasing.hpp>
+
+#define MOTION_SIZE 4 ///< Servos one group can move (thrust left and right, tilt and turn).
+
+void motionBegin(bool apart = false); ///< Start a group. Groups nest, the outermost motionCommit() starts the moves. An apart group's moves arrive together on their own, not with the outer group's.
+void motionMove(ServoEasing &servo, int degrees, uint16_t speed); ///< Add a move at speed degrees/second. Outside a group it starts now.
+void motionCommit(); ///< End a group. The outermost starts every move, stretched to take as long as the slowest it arrives with.
+
+int motionCurve(ServoEasing &servo, const uint8_t curve[]); ///< Play a PROGMEM curve (see ahkcurve.h) from its first key. Returns the angle it ends at.
+void motionUpdate(); ///< Step playing curves. Called from the main loop.
+bool motionNextDue(unsigned long &due); ///< millis() motionUpdate() next has work, false if no curve is playing.
+
+#endif /* INCLUDED_AHKMOTION_H */
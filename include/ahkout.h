@@ -0,0 +1,35 @@
+/**
+ * @file ahkout.h
+ * @author John Scott
+ * @brief Shadow register of every HK and base light, the source of truth for their state.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_AHKOUT_H
+#define INCLUDED_AHKOUT_H
+
+//
+// Output bits, in PIN order of OUTPUT_PINS...
+//
+#define OUT_TAIL_LIGHTS 0x01
+#define OUT_SEARCH_LIGHTS 0x02
+#define OUT_LANDING_LIGHTS 0x04
+#define OUT_PLASMA_GUN 0x08
+#define OUT_BLUE_LIGHTS 0x10
+#define OUT_RED_LIGHTS 0x20
+#define OUT_COUNT 6
+
+#define OUT_DIRECT (OUT_TAIL_LIGHTS | OUT_SEARCH_LIGHTS) ///< Switched here, the rest are driven by LED effects (ahkleds.h).
+
+extern unsigned char outputState; ///< OUT_* bits that are on (or running an effect).
+
+inline bool isOutput(unsigned char mask) { return outputState & mask; } ///< Any of the masked outputs on.
+
+void outputsWrite(unsigned char mask, unsigned char values); ///< Set masked outputs, one write per port for the direct ones.
+void outputsBegin(); ///< Hold direct output writes until outputsCommit().
+void outputsCommit(); ///< Write every held output together.
+void outputsDrive(unsigned char mask, unsigned char levels); ///< Set masked pins without changing their state, one write per port. For effects.
+
+#endif /* INCLUDED_AHKOUT_H */
@@ -0,0 +1,56 @@
+/**
+ * @file ahkremote.h
+ * @author John Scott
+ * @brief IR remote profiles, built into 256-entry command lookup tables at compile time.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_AHKREMOTE_H
+#define INCLUDED_AHKREMOTE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+//
+// Remote profiles, select one with -DAHK_REMOTE=REMOTE_...
+//
+#define REMOTE_ELEGOO21 1 ///< 21 key "Car MP3" style remote (power, vol, |<< >|| >>|, EQ, ST/REPT, 0-9).
+#define REMOTE_KEYES17 2 ///< 17 key remote (arrows, OK, *, #, 0-9).
+
+#ifndef AHK_REMOTE
+#define AHK_REMOTE REMOTE_ELEGOO21
+#endif
+
+struct IRKey {
+  uint8_t code; ///< NEC command byte.
+  char cmd; ///< CTL_* command it sends.
+};
+
+struct IRMap {
+  char cmds[256]; ///< CTL_* command by NEC command byte, '\0' if unused.
+};
+
+template<size_t N>
+constexpr bool irKeysUnique(const struct IRKey (&keys)[N]) {
+  for(size_t i = 0; i < N; ++i) {
+    for(size_t j = i + 1; j < N; ++j) {
+      if(keys[i].code == keys[j].code) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template<size_t N>
+constexpr struct IRMap buildIRMap(const struct IRKey (&keys)[N]) {
+  struct IRMap map = {};
+  for(size_t i = 0; i < N; ++i) {
+    map.cmds[keys[i].code] = keys[i].cmd;
+  }
+  return map;
+}
+
+#endif /* INCLUDED_AHKREMOTE_H */
@@ -0,0 +1,42 @@
+/**
+ * @file ahkscene.h
+ * @author John Scott
+ * @brief Aerial HK scene library.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_AHKSCENE_H
+#define INCLUDED_AHKSCENE_H
+
+#include <stdint.h>
+
+#define SCENE_COUNT 10 ///< Scenes selectable on number keys 0-9.
+
+//
+// Actuators, for CUE_INFO (see ahkcue.h)...
+//
+#define ACT_TAIL 0x0001
+#define ACT_LANDING 0x0002
+#define ACT_SEARCH 0x0004
+#define ACT_PLASMA 0x0008
+#define ACT_BLUE 0x0010
+#define ACT_RED 0x0020
+#define ACT_TILT 0x0040
+#define ACT_TURN 0x0080
+#define ACT_THRUST 0x0100
+#define ACT_SOUND 0x0200
+
+struct Scene {
+  const uint8_t *cues; ///< PROGMEM packed cue table (see ahkcue.h), or 0 for an empty slot.
+  void (*audio)(); ///< Soundtrack started with the first cue, or 0.
+  const char *name; ///< PROGMEM name the log shows when selected (%S in ahklog.h), or 0.
+  const uint8_t *keyframes; ///< PROGMEM keyframe index for seeking (see ahkcue.h), or 0 to seek from the start.
+};
+
+extern const struct Scene POWER_ON_SCENE; ///< PROGMEM power on sequence.
+extern const struct Scene POWER_OFF_SCENE; ///< PROGMEM power off sequence.
+extern const struct Scene SCENES[SCENE_COUNT]; ///< PROGMEM scene registry, indexed by number key.
+
+#endif /* INCLUDED_AHKSCENE_H */
@@ -0,0 +1,30 @@
+/**
+ * @file ahksched.h
+ * @author John Scott
+ * @brief Fixed-capacity event scheduler, a binary min-heap keyed on due time.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_AHKSCHED_H
+#define INCLUDED_AHKSCHED_H
+
+#define SCHED_SIZE 8 ///< Most events pending at once. Size from schedStats().highWater.
+
+typedef unsigned short SchedHandle; ///< Generation and slot. 0 is never a valid handle.
+
+struct SchedStats {
+  unsigned char pending; ///< Events waiting now.
+  unsigned char highWater; ///< Most events ever waiting at once.
+  unsigned short overflows; ///< Events refused because the heap was full.
+};
+
+SchedHandle schedule(void (*callback)(), unsigned long delay, unsigned long repeat = 0); ///< Call after delay ms, then every repeat ms if not 0. Returns 0 if full.
+bool schedCancel(SchedHandle handle); ///< Cancel an event. Stale handles are ignored.
+void schedCancelAll(); ///< Cancel every event.
+bool schedNextDue(unsigned long &due); ///< millis() the next event falls due, false if none.
+void schedRun(); ///< Call every event that is due. Called from the main loop.
+const struct SchedStats &schedStats(); ///< Occupancy statistics.
+
+#endif /* INCLUDED_AHKSCHED_H */
@@ -0,0 +1,30 @@
+/**
+ * @file ahksettings.h
+ * @author John Scott
+ * @brief Settings kept in EEPROM across power cycles and reflashes.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_AHKSETTINGS_H
+#define INCLUDED_AHKSETTINGS_H
+
+#define SETTINGS_VERSION 1 ///< Bump when struct Settings changes, older records are then ignored.
+#define SETTINGS_TRIM_MAX 20 ///< Largest servo trim either way (degrees).
+
+struct Settings {
+  unsigned char volume; ///< DFPlayer volume, VOL_MIN-VOL_MAX.
+  signed char thrustTrim; ///< Degrees added to AHK_THRUST_CENTRE (left thruster, mirrored on the right).
+  signed char tiltTrim; ///< Degrees added to every tilt angle.
+  signed char turnTrim; ///< Degrees added to every turn angle.
+};
+
+extern struct Settings settings; ///< Current settings. Call settingsChanged() after changing them.
+
+void setupAHKSettings(); ///< Load the newest record, or the defaults. First in setup().
+void loopAHKSettings(); ///< Save changed settings, a byte per pass.
+void settingsChanged(); ///< Save once the settings have stopped changing for SETTINGS_DELAY ms.
+bool settingsNextDue(unsigned long &due); ///< millis() loopAHKSettings() next has work, false if saved.
+
+#endif /* INCLUDED_AHKSETTINGS_H */
@@ -0,0 +1,43 @@
+/**
+ * @file ahkstats.h
+ * @author John Scott
+ * @brief Loop latency and cue jitter instrumentation. Build with -DAHK_STATS
+ * to enable, otherwise every hook compiles to nothing.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_AHKSTATS_H
+#define INCLUDED_AHKSTATS_H
+
+#ifdef AHK_STATS
+
+#include <Arduino.h>
+
+#define STATS_LOOP_AHK 0 ///< loopAHK()
+#define STATS_LOOP_CTRL 1 ///< loopAHKCtrl()
+#define STATS_LOOP_FX 2 ///< loopAHKEffects()
+#define STATS_HANDLERS 3
+#define STATS_BUCKETS 16 ///< log2 microsecond buckets of loop period.
+
+void statsHandler(unsigned char handler, unsigned long start); ///< Record a handler that started at micros() start.
+void statsLoop(); ///< Record the period since the last loop().
+void statsAckWait(unsigned long ms); ///< Record time a sound command waited for "OK".
+void statsDump(); ///< Print and reset the counters.
+
+#define STATS_BEGIN() unsigned long statsStart = micros()
+#define STATS_END(HANDLER) statsHandler(HANDLER, statsStart)
+#define STATS_LOOP() statsLoop()
+#define STATS_ACK_WAIT(MS) statsAckWait(MS)
+
+#else
+
+#define STATS_BEGIN()
+#define STATS_END(HANDLER)
+#define STATS_LOOP()
+#define STATS_ACK_WAIT(MS)
+
+#endif /* AHK_STATS */
+
+#endif /* INCLUDED_AHKSTATS_H */
@@ -0,0 +1,56 @@
+/**
+ * @file ahkstream.h
+ * @author John Scott
+ * @brief Scenes streamed over the console instead of compiled into flash.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ *
+ * A scene file is:
+ *
+ *   ["AHKS"] [STREAM_VERSION] [CUE_ACTIONS count] [bytes of cues, 4 little endian]
+ *   [cues packed as ahkcue.h] [CUE_END]
+ *
+ * tools/ahkscene.py converts an AT_TIME list into a scene file and sends it.
+ * After an L on the console, console bytes are the file. They are read into a
+ * STREAM_WINDOW byte window, filled and read a half at a time so the host
+ * sends one half while the cues in the other are parsed, without a heap.
+ * The host may send up to the offset in each "Stream want" message, sent
+ * whenever a half is freed and repeated every STREAM_ASK ms while the
+ * stream waits, so an allowance lost from a full log costs only a delay.
+ *
+ * The cues play as they arrive. A streamed scene can't be paused or seeked,
+ * and any soundtrack is a cue. Console bytes past the header's length are
+ * left for the console's commands. An action the firmware doesn't have, a
+ * bad argument, a file ending without CUE_END or a stall of STREAM_TIMEOUT ms
+ * ends the scene, and bytes still arriving are discarded until the console
+ * is quiet.
+ */
+#ifndef INCLUDED_AHKSTREAM_H
+#define INCLUDED_AHKSTREAM_H
+
+#include "ahktimeline.h"
+
+#define STREAM_VERSION 1
+#define STREAM_WINDOW 64 ///< Bytes of scene buffered (power of 2).
+#define STREAM_HALF (STREAM_WINDOW / 2) ///< Bytes the host is given at a time.
+#define STREAM_ASK 250 ///< Milliseconds between repeats of the allowance while waiting.
+#define STREAM_TIMEOUT 5000 ///< Milliseconds waiting for a byte before giving up.
+#define STREAM_QUIET 200 ///< Milliseconds without a byte that end discarding.
+
+enum StreamRead : unsigned char {
+  STREAM_CUE, ///< A cue was read.
+  STREAM_WAIT, ///< The next cue hasn't all arrived.
+  STREAM_END ///< The scene has ended or was abandoned.
+};
+
+void streamBegin(); ///< Take console bytes as a scene file.
+void streamStop(); ///< Abandon the stream, discarding bytes still arriving.
+bool isStreaming(); ///< Console bytes belong to the stream, including while discarding.
+bool streamReady(); ///< Header read and everything asked for, or the whole file, arrived: time to play.
+void streamPoll(); ///< Move console bytes into the window and ask for more.
+enum StreamRead streamRead(struct AsyncTiming &cue); ///< Next cue of the stream.
+bool streamNextDue(unsigned long &due); ///< millis() the stream next needs polling, false if not streaming.
+
+#endif /* INCLUDED_AHKSTREAM_H */
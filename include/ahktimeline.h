@@ -0,0 +1,51 @@
+/**
+ * @file ahktimeline.h
+ * @author John Scott
+ * @brief Play a table of timed cues, firing each cue when it falls due.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_AHKTIMELINE_H
+#define INCLUDED_AHKTIMELINE_H
+
+#include <stdint.h>
+
+struct AsyncTiming {
+  void (*callback)();
+  unsigned long start;
+  unsigned long repeat;
+  unsigned char arg; ///< Argument for actions that take one, see timelineArg().
+};
+
+// Macros for AsyncTimings
+#define AT_TIME(START, FN) {FN, START, 0, 0}
+#define AT_THEN_EVERY(START, REPEAT, FN) {FN, START, REPEAT, 0}
+#define AT_WITH(START, FN, ARG) {FN, START, 0, ARG}
+#define END_TIMINGS {0,0,0,0}
+
+struct TimelineDrift {
+  unsigned short cue; ///< Index of the last cue fired.
+  unsigned long late; ///< Milliseconds the last cue fired after its start time.
+  unsigned long maxLate; ///< Latest any cue has fired.
+  unsigned short worstCue; ///< Index of the cue that fired latest.
+  unsigned long totalLate; ///< Sum of lateness, for the mean.
+  unsigned short cues; ///< Cues fired.
+};
+
+void timelinePlay(const uint8_t cues[]); ///< Play a PROGMEM packed cue table (see ahkcue.h) from now.
+void timelinePlay(const uint8_t cues[], unsigned long start, const uint8_t keys[] = 0); ///< Play with time 0 at millis() start. Cues already due fire at once. keys is the table's keyframe index, or 0.
+void timelineStream(unsigned long start); ///< Play the cues streamed over the console (see ahkstream.h) with time 0 at millis() start.
+void timelineStop(); ///< Stop the playing table. Repeating cues already started keep running.
+bool isTimelinePlaying(); ///< Cues still to fire.
+void timelinePause(); ///< Stop firing cues, holding the position. Repeating cues already started keep running.
+bool isTimelinePaused(); ///< Paused with cues still to fire.
+unsigned long timelinePosition(); ///< Milliseconds into the table, or where it is paused.
+void timelineSeek(unsigned long position, unsigned short keep); ///< Pause at position, in the state playing there leaves the actuators not in keep.
+void timelineResume(unsigned long start); ///< Play on from the paused position, reached at millis() start. Restarts repeating cues in step.
+const struct TimelineDrift &timelineDrift(); ///< Lateness of the cues fired so far.
+unsigned char timelineArg(); ///< Argument of the cue being fired.
+void timelineFire(void (*action)(), unsigned char arg); ///< Call a cue's action outside the table, arg for timelineArg().
+
+#endif /* INCLUDED_AHKTIMELINE_H */
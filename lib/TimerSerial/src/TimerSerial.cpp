@@ -0,0 +1,167 @@
+/**
+ * @file TimerSerial.cpp
+ * @author John Scott
+ * @brief Interrupt driven software serial port for the ATmega328, timed by Timer0.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#include <Arduino.h>
+#include <avr/interrupt.h>
+#include "TimerSerial.h"
+
+#define TS_TX_MASK (TIMER_SERIAL_TX_SIZE - 1)
+#define TS_RX_MASK (TIMER_SERIAL_RX_SIZE - 1)
+#define TS_RX_HIGH() (PIND & _BV(PD3)) ///< TIMER_SERIAL_RX_PIN.
+
+static uint8_t tsTicks; ///< Timer0 ticks a bit.
+static volatile uint8_t *tsTxPort;
+static uint8_t tsTxPin;
+
+static uint8_t tsTxBuf[TIMER_SERIAL_TX_SIZE];
+static volatile uint8_t tsTxHead = 0; ///< Written by write().
+static volatile uint8_t tsTxTail = 0; ///< Written by the interrupt.
+static volatile bool tsTxBusy = false; ///< Compare B interrupt running.
+static uint8_t tsTxByte; ///< Bits still to send.
+static uint8_t tsTxBit = 0; ///< 0 between bytes, 1-8 data bits, 9 stop bit.
+
+static uint8_t tsRxBuf[TIMER_SERIAL_RX_SIZE];
+static volatile uint8_t tsRxHead = 0; ///< Written by the interrupt.
+static volatile uint8_t tsRxTail = 0; ///< Written by read().
+static uint8_t tsRxByte; ///< Bits received so far.
+static uint8_t tsRxBit; ///< Data bits received.
+
+
+//
+// Send, one bit per compare B interrupt...
+//
+ISR(TIMER0_COMPB_vect) {
+  OCR0B += tsTicks;
+
+  if(tsTxBit == 0) {
+    if(tsTxHead == tsTxTail) {
+      TIMSK0 &= ~_BV(OCIE0B);
+      tsTxBusy = false;
+      return;
+    }
+    tsTxByte = tsTxBuf[tsTxTail];
+    tsTxTail = (tsTxTail + 1) & TS_TX_MASK;
+    *tsTxPort &= ~tsTxPin; // Start bit.
+  } else if(tsTxBit <= 8) {
+    if(tsTxByte & 1) {
+      *tsTxPort |= tsTxPin;
+    } else {
+      *tsTxPort &= ~tsTxPin;
+    }
+    tsTxByte >>= 1;
+  } else {
+    *tsTxPort |= tsTxPin; // Stop bit, the next interrupt starts another byte.
+    tsTxBit = 0;
+    return;
+  }
+  ++tsTxBit;
+}
+
+
+//
+// Receive, a start bit edge on INT1 then one compare A interrupt in the middle
+// of each bit...
+//
+ISR(INT1_vect) {
+  OCR0A = TCNT0 + tsTicks + tsTicks / 2;
+  TIFR0 = _BV(OCF0A);
+  TIMSK0 |= _BV(OCIE0A);
+  EIMSK &= ~_BV(INT1);
+  tsRxBit = 0;
+}
+
+ISR(TIMER0_COMPA_vect) {
+  OCR0A += tsTicks;
+
+  if(tsRxBit < 8) {
+    tsRxByte >>= 1;
+    if(TS_RX_HIGH()) {
+      tsRxByte |= 0x80;
+    }
+    ++tsRxBit;
+    return;
+  }
+
+  // Stop bit, keep the byte unless it is a framing error or there is no room.
+  uint8_t next = (tsRxHead + 1) & TS_RX_MASK;
+  if(TS_RX_HIGH() && next != tsRxTail) {
+    tsRxBuf[tsRxHead] = tsRxByte;
+    tsRxHead = next;
+  }
+  TIMSK0 &= ~_BV(OCIE0A);
+  EIFR = _BV(INTF1);
+  EIMSK |= _BV(INT1);
+}
+
+
+//
+// Stream...
+//
+void TimerSerial::begin(long baud) {
+  tsTicks = (uint8_t)((F_CPU / 64 + baud / 2) / baud);
+  tsTxPort = portOutputRegister(digitalPinToPort(txPin_));
+  tsTxPin = digitalPinToBitMask(txPin_);
+
+  digitalWrite(txPin_, HIGH);
+  pinMode(txPin_, OUTPUT);
+  pinMode(TIMER_SERIAL_RX_PIN, INPUT_PULLUP);
+
+  uint8_t sreg = SREG;
+  cli();
+  TCCR0A = 0; // Normal mode, same prescaler and overflow for millis().
+  EICRA = (EICRA & ~(_BV(ISC11) | _BV(ISC10))) | _BV(ISC11); // INT1 on a falling edge.
+  EIFR = _BV(INTF1);
+  EIMSK |= _BV(INT1);
+  SREG = sreg;
+}
+
+int TimerSerial::available() {
+  return (tsRxHead - tsRxTail) & TS_RX_MASK;
+}
+
+int TimerSerial::read() {
+  int c = peek();
+  if(c >= 0) {
+    tsRxTail = (tsRxTail + 1) & TS_RX_MASK;
+  }
+  return c;
+}
+
+int TimerSerial::peek() {
+  if(tsRxHead == tsRxTail) {
+    return -1;
+  }
+  return tsRxBuf[tsRxTail];
+}
+
+void TimerSerial::flush() {
+  while(tsTxBusy) {
+  }
+}
+
+size_t TimerSerial::write(uint8_t c) {
+  uint8_t next = (tsTxHead + 1) & TS_TX_MASK;
+  while(next == tsTxTail) {
+    // Full, the interrupt frees a byte every ten bits.
+  }
+  tsTxBuf[tsTxHead] = c;
+  tsTxHead = next;
+
+  if(!tsTxBusy) {
+    uint8_t sreg = SREG;
+    cli();
+    tsTxBusy = true;
+    tsTxBit = 0;
+    OCR0B = TCNT0 + 2;
+    TIFR0 = _BV(OCF0B);
+    TIMSK0 |= _BV(OCIE0B);
+    SREG = sreg;
+  }
+  return 1;
+}
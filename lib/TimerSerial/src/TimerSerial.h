@@ -0,0 +1,47 @@
+/**
+ * @file TimerSerial.h
+ * @author John Scott
+ * @brief Interrupt driven software serial port for the ATmega328, timed by Timer0.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ *
+ * SoftwareSerial holds interrupts off for the whole of every byte it sends or
+ * receives, 87 us a byte at 115200 baud. TimerSerial queues bytes in ring
+ * buffers and moves one bit per interrupt instead: Timer0's compare B
+ * interrupt clocks bits out, a falling edge on INT1 (pin 3) finds each start
+ * bit and compare A samples the bits in. Each interrupt takes a few
+ * microseconds, so IR edges and servo pulses are delayed by no more than that.
+ *
+ * Timer0 keeps its prescaler of 64 (4 us a tick) and its overflow, so millis()
+ * and micros() are unaffected, but begin() switches it from fast PWM to normal
+ * mode so the compare registers can be moved on every bit. analogWrite() no
+ * longer works on pins 5 and 6. Bits are timed in whole ticks, so 19200 baud
+ * (13 ticks a bit) is the fastest usable rate. One port per sketch.
+ */
+#ifndef INCLUDED_TIMERSERIAL_H
+#define INCLUDED_TIMERSERIAL_H
+
+#include <Arduino.h>
+
+#define TIMER_SERIAL_RX_PIN 3 ///< INT1, the only pin that can receive.
+#define TIMER_SERIAL_TX_SIZE 64 ///< Bytes waiting to be sent (power of 2).
+#define TIMER_SERIAL_RX_SIZE 16 ///< Bytes received and not yet read (power of 2).
+
+class TimerSerial : public Stream {
+ public:
+  explicit TimerSerial(uint8_t txPin) : txPin_(txPin) {}
+  void begin(long baud); ///< Up to 19200.
+  int available() override;
+  int read() override;
+  int peek() override;
+  void flush() override; ///< Wait until every queued byte has been sent.
+  size_t write(uint8_t c) override; ///< Queue a byte, waiting only if the buffer is full.
+  using Print::write;
+
+ private:
+  uint8_t txPin_;
+};
+
+#endif /* INCLUDED_TIMERSERIAL_H */
@@ -0,0 +1,30 @@
+/**
+ * @file IRsmallDecoder.h
+ * @author John Scott
+ * @brief Native stand-in for IRsmallDecoder, fed by simIRInput().
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_IRSMALLDECODER_H
+#define INCLUDED_IRSMALLDECODER_H
+
+#include <Arduino.h>
+
+struct irSmallD_t {
+  uint8_t addr;
+  uint8_t cmd;
+  bool keyHeld;
+};
+
+class IRsmallDecoder {
+ public:
+  explicit IRsmallDecoder(uint8_t pin) : pin_(pin) {}
+  bool dataAvailable(irSmallD_t &data);
+
+ private:
+  uint8_t pin_;
+};
+
+#endif /* INCLUDED_IRSMALLDECODER_H */
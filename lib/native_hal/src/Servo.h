@@ -0,0 +1,28 @@
+/**
+ * @file Servo.h
+ * @author John Scott
+ * @brief Native stand-in for the Arduino Servo library.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_SERVO_H
+#define INCLUDED_SERVO_H
+
+#include <Arduino.h>
+
+class Servo {
+ public:
+  uint8_t attach(int pin) { pin_ = pin; return 0; }
+  void detach() { pin_ = -1; }
+  bool attached() const { return pin_ >= 0; }
+  void write(int degrees);
+  int read() const { return degrees_; }
+
+ protected:
+  int pin_ = -1;
+  int degrees_ = 90;
+};
+
+#endif /* INCLUDED_SERVO_H */
@@ -0,0 +1,51 @@
+/**
+ * @file ServoEasing.hpp
+ * @author John Scott
+ * @brief Native stand-in for ServoEasing, moving at constant speed in simulated time.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_SERVOEASING_HPP
+#define INCLUDED_SERVOEASING_HPP
+
+#include <Arduino.h>
+#include <Servo.h>
+
+#define EASE_LINEAR 0x00
+#define EASE_QUADRATIC_IN_OUT 0x03
+#define EASE_CUBIC_IN_OUT 0x07
+
+class ServoEasing : public Servo {
+ public:
+  uint8_t attach(int pin, int initialDegrees);
+  void setSpeed(uint16_t degreesPerSecond) { speed_ = degreesPerSecond; }
+  uint16_t getSpeed() const { return speed_; }
+  void setEasingType(uint8_t easingType) { easingType_ = easingType; }
+  void setTrim(int trimDegrees, bool doWrite = false) { trim_ = trimDegrees; (void)doWrite; } ///< Offsets the pulse only, angles are traced untrimmed.
+  int getTrim() const { return trim_; }
+  void write(int degrees); ///< Jump straight to an angle, ending any move.
+
+  bool startEaseTo(int degrees) { return startEaseTo(degrees, speed_); }
+  bool startEaseTo(int degrees, uint16_t degreesPerSecond, bool startUpdateByInterrupt = true);
+  bool startEaseToD(int degrees, uint16_t millisForMove, bool startUpdateByInterrupt = true);
+
+  bool isMoving();
+  int getCurrentAngle();
+  int getEndPosition() const { return end_; }
+  void stop();
+
+ private:
+  uint16_t speed_ = 5;
+  uint8_t easingType_ = EASE_LINEAR;
+  int trim_ = 0;
+  int start_ = 90;
+  int end_ = 90;
+  unsigned long startMillis_ = 0;
+  unsigned long durationMillis_ = 0;
+};
+
+inline void enableServoEasingInterrupt() {} ///< Nothing to start, moves follow the simulated clock.
+
+#endif /* INCLUDED_SERVOEASING_HPP */
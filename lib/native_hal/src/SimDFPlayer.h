@@ -0,0 +1,43 @@
+/**
+ * @file SimDFPlayer.h
+ * @author John Scott
+ * @brief Serial port with a simulated DFPlayer Pro attached, shared by the native serial stand-ins.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ *
+ * The player replies "OK" to every command line. Each byte sent or received
+ * is passed to byteSent() or byteReceived() with the simulated time it is on
+ * the wire, so a port can record how long it holds interrupts off.
+ */
+#ifndef INCLUDED_SIMDFPLAYER_H
+#define INCLUDED_SIMDFPLAYER_H
+
+#include <Arduino.h>
+#include <string>
+
+class SimDFPlayer : public Stream {
+ public:
+  void begin(long baud) { baud_ = baud; }
+  int available() override;
+  int read() override;
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+ protected:
+  explicit SimDFPlayer(uint8_t txPin) : txPin_(txPin) {}
+  uint64_t byteMicros() const { return (10000000 + baud_ / 2) / baud_; } ///< Ten bits on the wire.
+  virtual void byteSent(uint64_t at) = 0; ///< Byte starts going out at simulated time at.
+  virtual void byteReceived(uint64_t at) = 0; ///< Reply byte's start bit arrives at at.
+
+ private:
+  uint8_t txPin_;
+  long baud_ = 9600;
+  uint64_t txFree_ = 0; ///< When the last queued byte has been sent.
+  std::string line_; ///< Command being sent to the DFPlayer.
+  std::string reply_; ///< Pending reply from the DFPlayer.
+  uint64_t replyAt_ = 0; ///< Simulated time the reply arrives.
+};
+
+#endif /* INCLUDED_SIMDFPLAYER_H */
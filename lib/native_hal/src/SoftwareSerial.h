@@ -0,0 +1,25 @@
+/**
+ * @file SoftwareSerial.h
+ * @author John Scott
+ * @brief Native stand-in for SoftwareSerial with a simulated DFPlayer Pro attached.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_SOFTWARESERIAL_H
+#define INCLUDED_SOFTWARESERIAL_H
+
+#include "SimDFPlayer.h"
+
+// Interrupts are held off for all ten bits of every byte sent or received.
+class SoftwareSerial : public SimDFPlayer {
+ public:
+  SoftwareSerial(uint8_t rxPin, uint8_t txPin) : SimDFPlayer(txPin) { (void)rxPin; }
+
+ protected:
+  void byteSent(uint64_t at) override;
+  void byteReceived(uint64_t at) override;
+};
+
+#endif /* INCLUDED_SOFTWARESERIAL_H */
@@ -0,0 +1,28 @@
+/**
+ * @file TimerSerial.h
+ * @author John Scott
+ * @brief Native stand-in for TimerSerial with a simulated DFPlayer Pro attached.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_TIMERSERIAL_H
+#define INCLUDED_TIMERSERIAL_H
+
+#include "SimDFPlayer.h"
+
+#define TIMER_SERIAL_RX_PIN 3 ///< INT1, the only pin that can receive.
+#define TIMER_SERIAL_ISR_US 4 ///< Interrupts held off by each bit interrupt.
+
+// Interrupts are held off briefly once a bit, and for the start bit edge.
+class TimerSerial : public SimDFPlayer {
+ public:
+  explicit TimerSerial(uint8_t txPin) : SimDFPlayer(txPin) {}
+
+ protected:
+  void byteSent(uint64_t at) override;
+  void byteReceived(uint64_t at) override;
+};
+
+#endif /* INCLUDED_TIMERSERIAL_H */
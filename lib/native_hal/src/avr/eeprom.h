@@ -0,0 +1,24 @@
+/**
+ * @file eeprom.h
+ * @author John Scott
+ * @brief Native stand-in for avr/eeprom.h, the ATmega328P's 1 KB EEPROM with its 3.3 ms byte writes.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_AVR_EEPROM_H
+#define INCLUDED_AVR_EEPROM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define E2END 0x3FF ///< Last EEPROM address.
+
+bool eeprom_is_ready(); ///< False until a byte write has finished.
+uint8_t eeprom_read_byte(const uint8_t *addr);
+void eeprom_read_block(void *dst, const void *src, size_t n);
+void eeprom_update_byte(uint8_t *addr, uint8_t value); ///< Waits for the EEPROM, writes only if the byte differs.
+void eeprom_update_block(const void *src, void *dst, size_t n);
+
+#endif /* INCLUDED_AVR_EEPROM_H */
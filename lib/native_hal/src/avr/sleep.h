@@ -0,0 +1,18 @@
+/**
+ * @file sleep.h
+ * @author John Scott
+ * @brief Native stand-in for avr/sleep.h. Sleeping moves the simulated clock to the next interrupt.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_AVR_SLEEP_H
+#define INCLUDED_AVR_SLEEP_H
+
+#define SLEEP_MODE_IDLE 0
+
+inline void set_sleep_mode(int mode) { (void)mode; }
+void sleep_mode(); ///< Sleep until the next millis() tick, input or DFPlayer reply.
+
+#endif /* INCLUDED_AVR_SLEEP_H */
@@ -0,0 +1,741 @@
+/**
+ * @file hal_sim.cpp
+ * @author John Scott
+ * @brief Simulated Arduino core and peripherals for the native build.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <set>
+#include <Arduino.h>
+#include <IRsmallDecoder.h>
+#include <ServoEasing.hpp>
+#include <SoftwareSerial.h>
+#include <TimerSerial.h>
+#include <avr/eeprom.h>
+#include <avr/sleep.h>
+#include "hal_sim.h"
+
+HardwareSerial Serial;
+bool simQuiet = false;
+
+static uint64_t simClock = 0;
+static uint64_t simAckDelay = 5000;
+static std::vector<SimEvent> simEvents;
+static std::deque<char> simConsoleInput;
+static std::deque<uint8_t> simIRQueue;
+static int simPins[NUM_DIGITAL_PINS];
+static uint32_t simRandom = 1;
+static std::multimap<uint64_t, std::pair<bool, int> > simInputs; ///< Time, IR and key or command.
+static std::multiset<uint64_t> simWakes;
+static uint64_t simSlept = 0;
+
+
+//
+// Simulated clock...
+//
+uint64_t simMicros() {
+  return simClock;
+}
+
+void simAdvance(uint64_t us) {
+  simClock += us;
+
+  while(!simInputs.empty() && simInputs.begin()->first <= simClock) {
+    if(simInputs.begin()->second.first) {
+      simIRInput((uint8_t)simInputs.begin()->second.second);
+    } else {
+      simSerialInput((char)simInputs.begin()->second.second);
+    }
+    simInputs.erase(simInputs.begin());
+  }
+}
+
+void simInputAt(uint64_t us, bool ir, int value) {
+  simInputs.insert(std::make_pair(us, std::make_pair(ir, value)));
+  simWakeAt(us);
+}
+
+void simWakeAt(uint64_t us) {
+  simWakes.insert(us);
+}
+
+// Idle sleep, until Timer0 next moves millis() on or an earlier interrupt.
+void sleep_mode() {
+  uint64_t wake = (simClock / 1000 + 1) * 1000;
+
+  while(!simWakes.empty() && *simWakes.begin() <= simClock) {
+    simWakes.erase(simWakes.begin());
+  }
+  if(!simWakes.empty() && *simWakes.begin() < wake) {
+    wake = *simWakes.begin();
+  }
+
+  simSlept += wake - simClock;
+  simAdvance(wake - simClock);
+}
+
+uint64_t simAsleep() {
+  return simSlept;
+}
+
+unsigned long millis() {
+  return (unsigned long)(simClock / 1000);
+}
+
+unsigned long micros() {
+  return (unsigned long)simClock;
+}
+
+void delay(unsigned long ms) {
+  simAdvance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  simAdvance(us);
+}
+
+
+//
+// Output trace...
+//
+void simRecord(SimEventKind kind, int id, int value, int arg, const std::string &text) {
+  simEvents.push_back(SimEvent{simClock, kind, id, value, arg, text});
+}
+
+const std::vector<SimEvent> &simTrace() {
+  return simEvents;
+}
+
+// Fade and curve steps, left out of traces unless asked for.
+static bool simRamp(SimEventKind kind) {
+  return kind == SIM_PWM || kind == SIM_STEP;
+}
+
+// Trace lines read "<ms> <channel> <value>", e.g. "1000.000 SERVO 9 120 50".
+// Changes on one channel (a pin, a servo or the DFPlayer) stay in order.
+static std::string simChannel(const SimEvent &e) {
+  switch(e.kind) {
+    case SIM_PIN: return "PIN " + std::to_string(e.id);
+    case SIM_PWM: return "PWM " + std::to_string(e.id);
+    case SIM_STEP: return "STEP " + std::to_string(e.id);
+    case SIM_SERVO: return "SERVO " + std::to_string(e.id);
+    default: return "SOUND";
+  }
+}
+
+static std::string simValue(const SimEvent &e) {
+  switch(e.kind) {
+    case SIM_SERVO: return std::to_string(e.value) + " " + std::to_string(e.arg);
+    case SIM_SOUND: return e.text;
+    default: return std::to_string(e.value);
+  }
+}
+
+void simPrintTrace(FILE *out, bool ramps) {
+  for(const SimEvent &e : simEvents) {
+    if(!simRamp(e.kind) || ramps) {
+      fprintf(out, "%10.3f %s %s\n", e.us / 1000.0, simChannel(e).c_str(), simValue(e).c_str());
+    }
+  }
+}
+
+typedef std::vector<std::pair<double, std::string>> SimChannelTrace;
+
+bool simCompareTrace(FILE *golden, double tolerance, bool ramps) {
+  std::map<std::string, SimChannelTrace> expected, recorded;
+  char line[256];
+
+  while(fgets(line, sizeof(line), golden)) {
+    double ms;
+    char kind[16];
+    int n = 0;
+
+    line[strcspn(line, "\r\n")] = '\0';
+    if(sscanf(line, "%lf %15s %n", &ms, kind, &n) < 2) {
+      continue;
+    }
+
+    std::string channel = kind, value = line + n;
+    if(channel != "SOUND") {
+      size_t space = value.find(' ');
+      channel += " " + value.substr(0, space);
+      value = space == std::string::npos ? "" : value.substr(space + 1);
+    }
+    if((channel.compare(0, 3, "PWM") && channel.compare(0, 4, "STEP")) || ramps) {
+      expected[channel].push_back(std::make_pair(ms, value));
+    }
+  }
+
+  for(const SimEvent &e : simEvents) {
+    if(!simRamp(e.kind) || ramps) {
+      recorded[simChannel(e)].push_back(std::make_pair(e.us / 1000.0, simValue(e)));
+    }
+  }
+
+  for(const auto &channel : recorded) {
+    expected[channel.first];
+  }
+
+  bool match = true;
+  double worst = 0;
+
+  for(const auto &channel : expected) {
+    const SimChannelTrace &want = channel.second;
+    const SimChannelTrace &got = recorded[channel.first];
+
+    for(size_t i = 0; i < want.size() || i < got.size(); ++i) {
+      if(i >= want.size() || i >= got.size() || want[i].second != got[i].second) {
+        fprintf(stderr, "%s change %zu: expected \"%s\" at %.3f, recorded \"%s\" at %.3f\n", channel.first.c_str(), i,
+          i < want.size() ? want[i].second.c_str() : "nothing", i < want.size() ? want[i].first : 0.0,
+          i < got.size() ? got[i].second.c_str() : "nothing", i < got.size() ? got[i].first : 0.0);
+        match = false;
+        break;
+      }
+
+      double jitter = fabs(got[i].first - want[i].first);
+      if(jitter > worst) {
+        worst = jitter;
+      }
+      if(jitter > tolerance) {
+        fprintf(stderr, "%s change %zu: \"%s\" expected at %.3f, recorded at %.3f\n", channel.first.c_str(), i,
+          want[i].second.c_str(), want[i].first, got[i].first);
+        match = false;
+      }
+    }
+  }
+
+  fprintf(stderr, "%s golden trace, worst jitter %.3f ms (tolerance %.3f ms)\n", match ? "Matches" : "DIFFERS from", worst, tolerance);
+  return match;
+}
+
+
+//
+// Pins...
+//
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+static void simPinWrite(uint8_t pin, int value) {
+  if(pin < NUM_DIGITAL_PINS && simPins[pin] != value) {
+    simPins[pin] = value;
+    simRecord(SIM_PIN, pin, value);
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  simPinWrite(pin, value ? HIGH : LOW);
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < NUM_DIGITAL_PINS && simPins[pin] ? HIGH : LOW;
+}
+
+void analogWrite(uint8_t pin, int value) {
+  if(digitalPinHasPWM(pin) && value > 0 && value < 255) {
+    if(pin < NUM_DIGITAL_PINS && simPins[pin] != value) {
+      simPins[pin] = value;
+      simRecord(SIM_PWM, pin, value);
+    }
+  } else {
+    simPinWrite(pin, value < 128 ? LOW : HIGH);
+  }
+}
+
+int analogRead(uint8_t pin) {
+  (void)pin;
+  return (int)random(1024);
+}
+
+
+//
+// Random numbers (Park-Miller, as avr-libc)...
+//
+void randomSeed(unsigned long seed) {
+  if(seed) {
+    simRandom = (uint32_t)seed;
+  }
+}
+
+long random(long howbig) {
+  if(howbig <= 0) {
+    return 0;
+  }
+
+  int32_t hi = simRandom / 127773;
+  int32_t lo = simRandom % 127773;
+  int32_t x = 16807 * lo - 2836 * hi;
+  if(x <= 0) {
+    x += 0x7fffffff;
+  }
+  simRandom = x;
+
+  return x % howbig;
+}
+
+long random(long howsmall, long howbig) {
+  return howsmall >= howbig ? howsmall : random(howbig - howsmall) + howsmall;
+}
+
+
+//
+// Print...
+//
+size_t Print::write(const char *str) {
+  return write((const uint8_t *)str, strlen(str));
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while(size--) {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::print(const __FlashStringHelper *str) {
+  return write(reinterpret_cast<const char *>(str));
+}
+
+size_t Print::print(const char *str) {
+  return write(str);
+}
+
+size_t Print::print(char c) {
+  return write((uint8_t)c);
+}
+
+size_t Print::print(int n, int base) {
+  return print((long)n, base);
+}
+
+size_t Print::print(unsigned int n, int base) {
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(long n, int base) {
+  if(base == DEC && n < 0) {
+    return print('-') + print((unsigned long)-n, base);
+  }
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  char buf[8 * sizeof(long) + 1];
+  char *str = &buf[sizeof(buf) - 1];
+
+  *str = '\0';
+  do {
+    char c = n % base;
+    n /= base;
+    *--str = c < 10 ? c + '0' : c + 'A' - 10;
+  } while(n);
+
+  return write(str);
+}
+
+size_t Print::println() {
+  return write("\r\n");
+}
+
+size_t Print::println(const __FlashStringHelper *str) {
+  return print(str) + println();
+}
+
+size_t Print::println(const char *str) {
+  return print(str) + println();
+}
+
+size_t Print::println(char c) {
+  return print(c) + println();
+}
+
+size_t Print::println(int n, int base) {
+  return print(n, base) + println();
+}
+
+size_t Print::println(unsigned int n, int base) {
+  return print(n, base) + println();
+}
+
+size_t Print::println(long n, int base) {
+  return print(n, base) + println();
+}
+
+size_t Print::println(unsigned long n, int base) {
+  return print(n, base) + println();
+}
+
+
+//
+// Console...
+//
+void HardwareSerial::begin(unsigned long baud) {
+  (void)baud;
+}
+
+int HardwareSerial::available() {
+  return (int)simConsoleInput.size();
+}
+
+int HardwareSerial::read() {
+  if(simConsoleInput.empty()) {
+    return -1;
+  }
+
+  char c = simConsoleInput.front();
+  simConsoleInput.pop_front();
+  return (unsigned char)c;
+}
+
+int HardwareSerial::availableForWrite() {
+  return 63;
+}
+
+static void (*simTap)(uint8_t c) = nullptr;
+
+void simConsoleTap(void (*tap)(uint8_t c)) {
+  simTap = tap;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  if(!simQuiet && c != '\r') {
+    putchar(c);
+  }
+  if(simTap) {
+    simTap(c);
+  }
+  return 1;
+}
+
+void simSerialInput(char c) {
+  simConsoleInput.push_back(c);
+}
+
+
+//
+// DFPlayer Pro, replies "OK" to every command...
+//
+void simSetAckDelay(uint64_t us) {
+  simAckDelay = us;
+}
+
+int SimDFPlayer::available() {
+  return simClock >= replyAt_ ? (int)reply_.size() : 0;
+}
+
+int SimDFPlayer::read() {
+  if(!available()) {
+    return -1;
+  }
+
+  char c = reply_[0];
+  reply_.erase(0, 1);
+  return (unsigned char)c;
+}
+
+size_t SimDFPlayer::write(uint8_t c) {
+  uint64_t at = txFree_ > simClock ? txFree_ : simClock;
+  txFree_ = at + byteMicros();
+  byteSent(at);
+
+  if(c == '\n') {
+    static const std::string ok = "OK\r\n";
+
+    simRecord(SIM_SOUND, txPin_, 0, 0, line_);
+    line_.clear();
+    replyAt_ = simClock + simAckDelay;
+    for(size_t i = 0; i < ok.size(); ++i) {
+      byteReceived(replyAt_ + i * byteMicros());
+    }
+    simWakeAt(replyAt_);
+    reply_ += ok;
+  } else if(c != '\r') {
+    line_ += (char)c;
+  }
+  return 1;
+}
+
+void SoftwareSerial::byteSent(uint64_t at) {
+  simBlackout(at, byteMicros());
+}
+
+void SoftwareSerial::byteReceived(uint64_t at) {
+  simBlackout(at, byteMicros());
+}
+
+void TimerSerial::byteSent(uint64_t at) {
+  for(int bit = 0; bit < 10; ++bit) {
+    simBlackout(at + bit * byteMicros() / 10, TIMER_SERIAL_ISR_US);
+  }
+}
+
+void TimerSerial::byteReceived(uint64_t at) {
+  simBlackout(at, TIMER_SERIAL_ISR_US); // Start bit edge.
+  for(int bit = 1; bit < 10; ++bit) {
+    simBlackout(at + (bit * 10 + 5) * byteMicros() / 100, TIMER_SERIAL_ISR_US);
+  }
+}
+
+
+//
+// Interrupt blackouts, and what they would do to the IR receiver and servo
+// pulses. IR edges interrupt on INT0 and are timed when the interrupt runs;
+// an edge held back too far, or two edges in one blackout (the interrupt
+// flag holds only one), lose the frame. Servo pulses are ended by a Timer1
+// interrupt, so a blackout at either edge changes the width.
+//
+#define SIM_IR_PERIOD 110000 ///< A NEC frame every 110 ms, a key held down.
+#define SIM_IR_TOLERANCE 150 ///< Edge delay the decoder tolerates, about a quarter of a NEC bit.
+#define SIM_IR_CODE 0xBA45FF00UL ///< Address 0, command 0x45, and their inverses, sent low bit first.
+#define SIM_SERVO_COUNT 4
+#define SIM_SERVO_FRAME 20000 ///< Servo library refresh interval.
+#define SIM_SERVO_PULSE 1500 ///< Centred pulse, channels pulse one after another.
+#define SIM_SERVO_TOLERANCE 10 ///< Width error that moves a servo, about 2 degrees.
+
+static std::vector<std::pair<uint64_t, uint64_t> > simBlackouts; ///< Start and end.
+
+void simBlackout(uint64_t at, uint64_t us) {
+  simBlackouts.push_back(std::make_pair(at, at + us));
+}
+
+// Blackout covering us, or -1.
+static long simBlackoutAt(const std::vector<std::pair<uint64_t, uint64_t> > &merged, uint64_t us) {
+  auto after = std::upper_bound(merged.begin(), merged.end(), std::make_pair(us, UINT64_MAX));
+  if(after == merged.begin() || (after - 1)->second <= us) {
+    return -1;
+  }
+  return (long)(after - 1 - merged.begin());
+}
+
+static uint64_t simDelay(const std::vector<std::pair<uint64_t, uint64_t> > &merged, uint64_t us) {
+  long i = simBlackoutAt(merged, us);
+  return i < 0 ? 0 : merged[i].second - us;
+}
+
+void simPrintBlackouts(FILE *out, uint64_t until) {
+  std::vector<std::pair<uint64_t, uint64_t> > merged;
+  std::vector<std::pair<uint64_t, uint64_t> > sorted = simBlackouts;
+  uint64_t longest = 0, total = 0;
+
+  std::sort(sorted.begin(), sorted.end());
+  for(const auto &blackout : sorted) {
+    if(blackout.first >= until) {
+      break;
+    }
+    if(!merged.empty() && blackout.first <= merged.back().second) {
+      merged.back().second = std::max(merged.back().second, blackout.second);
+    } else {
+      merged.push_back(blackout);
+    }
+  }
+  for(const auto &blackout : merged) {
+    longest = std::max(longest, blackout.second - blackout.first);
+    total += blackout.second - blackout.first;
+  }
+
+  // NEC frame edges: 9 ms mark, 4.5 ms space, 32 bits of a 562 us mark and a
+  // 562 or 1687 us space, and a closing mark.
+  std::vector<uint64_t> edges = {0, 9000, 13500};
+  for(int bit = 0; bit < 32; ++bit) {
+    edges.push_back(edges.back() + 562);
+    edges.push_back(edges.back() + ((SIM_IR_CODE >> bit) & 1 ? 1687 : 562));
+  }
+  edges.push_back(edges.back() + 562);
+
+  size_t frames = 0, framesLost = 0;
+  for(uint64_t frame = 0; frame + edges.back() < until; frame += SIM_IR_PERIOD) {
+    long last = -1;
+    bool lost = false;
+
+    for(uint64_t edge : edges) {
+      long blackout = simBlackoutAt(merged, frame + edge);
+      lost |= blackout >= 0 && (blackout == last || merged[blackout].second - (frame + edge) > SIM_IR_TOLERANCE);
+      last = blackout;
+    }
+    ++frames;
+    framesLost += lost;
+  }
+
+  size_t pulses = 0, pulsesGlitched = 0;
+  for(uint64_t frame = 0; frame + SIM_SERVO_FRAME < until; frame += SIM_SERVO_FRAME) {
+    for(int servo = 0; servo < SIM_SERVO_COUNT; ++servo) {
+      uint64_t rise = frame + servo * SIM_SERVO_PULSE;
+      long error = (long)simDelay(merged, rise + SIM_SERVO_PULSE) - (long)simDelay(merged, rise);
+
+      ++pulses;
+      pulsesGlitched += error > SIM_SERVO_TOLERANCE || error < -SIM_SERVO_TOLERANCE;
+    }
+  }
+
+  fprintf(out, "Interrupt blackouts: %zu, longest %llu us, %.3f%% of the time\n",
+    merged.size(), (unsigned long long)longest, until ? 100.0 * total / until : 0);
+  fprintf(out, "IR frames lost: %zu of %zu (a NEC frame every %d ms)\n", framesLost, frames, SIM_IR_PERIOD / 1000);
+  fprintf(out, "Servo pulses glitched: %zu of %zu (width out by more than %d us)\n",
+    pulsesGlitched, pulses, SIM_SERVO_TOLERANCE);
+}
+
+
+//
+// EEPROM...
+//
+#define SIM_EEPROM_WRITE_US 3400 ///< Erase and write of one byte.
+
+static uint8_t simEeprom[E2END + 1];
+static bool simEepromErased = false;
+static uint64_t simEepromReadyAt = 0;
+static unsigned long simEepromWritten = 0;
+
+static void simEepromInit() {
+  if(!simEepromErased) {
+    memset(simEeprom, 0xFF, sizeof(simEeprom));
+    simEepromErased = true;
+  }
+}
+
+bool simLoadEeprom(const char *path) {
+  FILE *in = fopen(path, "rb");
+  simEepromInit();
+  if(!in) {
+    return false;
+  }
+  bool ok = fread(simEeprom, 1, sizeof(simEeprom), in) == sizeof(simEeprom);
+  fclose(in);
+  return ok;
+}
+
+bool simSaveEeprom(const char *path) {
+  FILE *out = fopen(path, "wb");
+  simEepromInit();
+  if(!out) {
+    return false;
+  }
+  bool ok = fwrite(simEeprom, 1, sizeof(simEeprom), out) == sizeof(simEeprom);
+  return fclose(out) == 0 && ok;
+}
+
+unsigned long simEepromWrites() {
+  return simEepromWritten;
+}
+
+bool eeprom_is_ready() {
+  return simClock >= simEepromReadyAt;
+}
+
+uint8_t eeprom_read_byte(const uint8_t *addr) {
+  simEepromInit();
+  return simEeprom[(uintptr_t)addr & E2END];
+}
+
+void eeprom_read_block(void *dst, const void *src, size_t n) {
+  for(size_t i = 0; i < n; ++i) {
+    ((uint8_t *)dst)[i] = eeprom_read_byte((const uint8_t *)src + i);
+  }
+}
+
+void eeprom_update_byte(uint8_t *addr, uint8_t value) {
+  if(eeprom_read_byte(addr) == value) {
+    return;
+  }
+  if(!eeprom_is_ready()) {
+    simAdvance(simEepromReadyAt - simClock);
+  }
+  simEeprom[(uintptr_t)addr & E2END] = value;
+  simEepromReadyAt = simClock + SIM_EEPROM_WRITE_US;
+  ++simEepromWritten;
+}
+
+void eeprom_update_block(const void *src, void *dst, size_t n) {
+  for(size_t i = 0; i < n; ++i) {
+    eeprom_update_byte((uint8_t *)dst + i, ((const uint8_t *)src)[i]);
+  }
+}
+
+
+//
+// IR receiver...
+//
+void simIRInput(uint8_t cmd) {
+  simIRQueue.push_back(cmd);
+}
+
+bool IRsmallDecoder::dataAvailable(irSmallD_t &data) {
+  if(simIRQueue.empty()) {
+    return false;
+  }
+
+  data.addr = 0;
+  data.cmd = simIRQueue.front();
+  data.keyHeld = false;
+  simIRQueue.pop_front();
+  return true;
+}
+
+
+//
+// Servos...
+//
+void Servo::write(int degrees) {
+  degrees_ = degrees;
+}
+
+uint8_t ServoEasing::attach(int pin, int initialDegrees) {
+  Servo::attach(pin);
+  start_ = end_ = initialDegrees;
+  Servo::write(initialDegrees);
+  simRecord(SIM_SERVO, pin, initialDegrees, 0);
+  return 0;
+}
+
+void ServoEasing::write(int degrees) {
+  start_ = end_ = degrees;
+  durationMillis_ = 0;
+  Servo::write(degrees);
+  simRecord(SIM_STEP, pin_, degrees);
+}
+
+bool ServoEasing::startEaseTo(int degrees, uint16_t degreesPerSecond, bool startUpdateByInterrupt) {
+  (void)startUpdateByInterrupt; // Moves are stepped from the simulated clock.
+  start_ = getCurrentAngle();
+  end_ = degrees;
+  startMillis_ = millis();
+  durationMillis_ = degreesPerSecond ? (unsigned long)abs(end_ - start_) * 1000 / degreesPerSecond : 0;
+  simRecord(SIM_SERVO, pin_, degrees, degreesPerSecond);
+  return true;
+}
+
+bool ServoEasing::startEaseToD(int degrees, uint16_t millisForMove, bool startUpdateByInterrupt) {
+  (void)startUpdateByInterrupt;
+  start_ = getCurrentAngle();
+  end_ = degrees;
+  startMillis_ = millis();
+  durationMillis_ = millisForMove;
+  // Traced as the effective speed, so the trace reads the same either way.
+  simRecord(SIM_SERVO, pin_, degrees, millisForMove ? abs(end_ - start_) * 1000 / millisForMove : 0);
+  return true;
+}
+
+bool ServoEasing::isMoving() {
+  return millis() - startMillis_ < durationMillis_;
+}
+
+int ServoEasing::getCurrentAngle() {
+  if(!isMoving()) {
+    degrees_ = end_;
+  } else {
+    degrees_ = start_ + (int)((long)(end_ - start_) * (long)(millis() - startMillis_) / (long)durationMillis_);
+  }
+  return degrees_;
+}
+
+void ServoEasing::stop() {
+  end_ = getCurrentAngle();
+  durationMillis_ = 0;
+}
+
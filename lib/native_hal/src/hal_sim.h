@@ -0,0 +1,75 @@
+/**
+ * @file hal_sim.h
+ * @author John Scott
+ * @brief Simulated clock, input injection and output trace for the native build.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_HAL_SIM_H
+#define INCLUDED_HAL_SIM_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+//
+// Simulated clock...
+//
+uint64_t simMicros(); ///< Simulated time since power on.
+void simAdvance(uint64_t us); ///< Move the simulated clock forward.
+
+//
+// Inputs...
+//
+void simSerialInput(char c); ///< Queue a console character.
+void simIRInput(uint8_t cmd); ///< Queue a decoded NEC IR command.
+void simSetAckDelay(uint64_t us); ///< DFPlayer "OK" reply latency.
+void simInputAt(uint64_t us, bool ir, int value); ///< Deliver a console key, or IR command if ir, at simulated time us.
+void simWakeAt(uint64_t us); ///< An interrupt at us wakes a sleeping CPU.
+uint64_t simAsleep(); ///< Simulated time spent in sleep_mode().
+void simConsoleTap(void (*tap)(uint8_t c)); ///< Also pass each byte the firmware writes to the console to tap.
+
+//
+// Interrupt blackouts...
+//
+void simBlackout(uint64_t at, uint64_t us); ///< Interrupts held off for us from simulated time at.
+void simPrintBlackouts(FILE *out, uint64_t until); ///< Blackouts to until, and the IR frames and servo pulses they would spoil.
+
+//
+// EEPROM, erased (0xFF) at power on unless loaded from an image file...
+//
+bool simLoadEeprom(const char *path); ///< Start with the image in path. False if it can't be read.
+bool simSaveEeprom(const char *path); ///< Write the image to path.
+unsigned long simEepromWrites(); ///< Bytes written since power on.
+
+//
+// Output trace...
+//
+enum SimEventKind {
+  SIM_PIN, ///< Pin level changed (id = pin).
+  SIM_PWM, ///< Pin PWM duty changed part way through a fade (id = pin).
+  SIM_SERVO, ///< Servo move started (id = pin, value = target, arg = speed).
+  SIM_STEP, ///< Servo written directly part way through a curve (id = pin).
+  SIM_SOUND ///< Command line sent to the DFPlayer (text).
+};
+
+struct SimEvent {
+  uint64_t us; ///< Simulated time of the change.
+  SimEventKind kind; ///< What changed.
+  int id; ///< Pin number.
+  int value; ///< New level, duty or target.
+  int arg; ///< Servo speed.
+  std::string text; ///< Sound command.
+};
+
+void simRecord(SimEventKind kind, int id, int value, int arg = 0, const std::string &text = "");
+const std::vector<SimEvent> &simTrace(); ///< Every recorded change, in time order.
+void simPrintTrace(FILE *out, bool ramps = false); ///< Write the trace as text, one change per line. Fade and curve steps only if ramps.
+bool simCompareTrace(FILE *golden, double tolerance, bool ramps = false); ///< Compare with a printed trace, allowing tolerance ms of jitter.
+
+extern bool simQuiet; ///< Suppress console (Serial) output.
+
+#endif /* INCLUDED_HAL_SIM_H */
@@ -0,0 +1,138 @@
+/**
+ * @file jled.h
+ * @author John Scott
+ * @brief Native stand-in for JLed, covering the effects the HK uses.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#ifndef INCLUDED_JLED_H
+#define INCLUDED_JLED_H
+
+#include <Arduino.h>
+
+namespace jled {
+
+// Writes the pin and reads the clock for an effect, as JLed's ArduinoHal.
+class ArduinoHal {
+ public:
+  using PinType = uint8_t;
+  explicit ArduinoHal(PinType pin) : pin_(pin) {}
+  void analogWrite(uint8_t val) const { ::analogWrite(pin_, val); }
+  uint32_t millis() const { return ::millis(); }
+
+ private:
+  PinType pin_;
+};
+
+// Effect on the LED behind HalType. B is the derived class, returned by the
+// chained setters.
+template<typename HalType, typename B>
+class TJLed {
+ public:
+  explicit TJLed(typename HalType::PinType pin) : hal_(pin) {}
+
+  B &On() { return Set(EFFECT_ON, 1, 0, 0); }
+  B &Off() { return Set(EFFECT_OFF, 1, 0, 0); }
+  B &Blink(uint16_t on, uint16_t off) { return Set(EFFECT_BLINK, on, off, 0); }
+  B &FadeOn(uint16_t period) { return Set(EFFECT_FADE_ON, period, 0, 0); }
+  B &FadeOff(uint16_t period) { return Set(EFFECT_FADE_OFF, period, 0, 0); }
+  B &Breathe(uint16_t period) { return Set(EFFECT_BREATHE, period / 2, 0, period - period / 2); }
+  B &Breathe(uint16_t fadeOn, uint16_t on, uint16_t fadeOff) { return Set(EFFECT_BREATHE, fadeOn, on, fadeOff); }
+
+  B &Repeat(uint16_t n) { repeat_ = n; forever_ = false; return Self(); }
+  B &Forever() { forever_ = true; return Self(); }
+  B &Reset() { state_ = ST_INIT; return Self(); }
+  B &Stop() { Write(0); state_ = ST_STOPPED; return Self(); }
+
+  bool IsRunning() const { return state_ != ST_STOPPED; }
+
+  bool Update() {
+    if(state_ == ST_STOPPED) {
+      return false;
+    }
+
+    uint32_t now = hal_.millis();
+    if(state_ == ST_INIT) {
+      start_ = now;
+      state_ = ST_RUNNING;
+    }
+
+    uint32_t period = Period();
+    uint32_t elapsed = now - start_;
+    if(!forever_ && elapsed >= period * repeat_) {
+      Write(Eval(period - 1));
+      state_ = ST_STOPPED;
+      return false;
+    }
+
+    Write(Eval(elapsed % period));
+    return true;
+  }
+
+ private:
+  enum Effect { EFFECT_OFF, EFFECT_ON, EFFECT_BLINK, EFFECT_FADE_ON, EFFECT_FADE_OFF, EFFECT_BREATHE };
+  enum State { ST_STOPPED, ST_INIT, ST_RUNNING };
+
+  B &Self() { return static_cast<B &>(*this); }
+
+  B &Set(Effect effect, uint16_t a, uint16_t b, uint16_t c) {
+    effect_ = effect;
+    a_ = a;
+    b_ = b;
+    c_ = c;
+    repeat_ = 1;
+    forever_ = false;
+    state_ = ST_INIT;
+    return Self();
+  }
+
+  uint32_t Period() const {
+    uint32_t period = (uint32_t)a_ + b_ + c_;
+    return period ? period : 1;
+  }
+
+  uint8_t Ramp(uint32_t t, uint32_t period) const {
+    return period > 1 ? (uint8_t)(t * 255 / (period - 1)) : 255;
+  }
+
+  uint8_t Eval(uint32_t t) const {
+    switch(effect_) {
+      case EFFECT_ON: return 255;
+      case EFFECT_BLINK: return t < a_ ? 255 : 0;
+      case EFFECT_FADE_ON: return Ramp(t, a_);
+      case EFFECT_FADE_OFF: return 255 - Ramp(t, a_);
+      case EFFECT_BREATHE:
+        if(t < a_) return Ramp(t, a_);
+        if(t < (uint32_t)a_ + b_) return 255;
+        return 255 - Ramp(t - a_ - b_, c_);
+      default: return 0;
+    }
+  }
+
+  void Write(uint8_t brightness) {
+    if(brightness != brightness_) {
+      brightness_ = brightness;
+      hal_.analogWrite(brightness);
+    }
+  }
+
+  HalType hal_;
+  Effect effect_ = EFFECT_OFF;
+  uint16_t a_ = 1, b_ = 0, c_ = 0;
+  uint16_t repeat_ = 1;
+  bool forever_ = false;
+  State state_ = ST_INIT;
+  uint32_t start_ = 0;
+  int16_t brightness_ = -1;
+};
+
+} // namespace jled
+
+class JLed : public jled::TJLed<jled::ArduinoHal, JLed> {
+ public:
+  using jled::TJLed<jled::ArduinoHal, JLed>::TJLed;
+};
+
+#endif /* INCLUDED_JLED_H */
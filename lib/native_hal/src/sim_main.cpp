@@ -0,0 +1,297 @@
+/**
+ * @file sim_main.cpp
+ * @author John Scott
+ * @brief Native entry point. Runs setup() and loop() against the simulated clock.
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ *
+ * Usage: program [-d seconds] [-s loop-us] [-a ack-us] [-k ms:key] [-i ms:hex] [-q] [-t] [-r] [-b]
+ *                [-o trace-file] [-g golden-file] [-j jitter-ms] [-e eeprom-file] [-f ms:scene-file]
+ *                [-x ms:hex-bytes]
+ *
+ *   -d  Simulated run time in seconds (default 10).
+ *   -s  Simulated microseconds each loop() pass costs on the Nano (default 100).
+ *   -a  DFPlayer "OK" reply latency in microseconds (default 5000).
+ *   -k  Type a console key at a simulated millisecond, e.g. -k 1000:1
+ *   -i  Press an IR remote key (NEC command byte) at a simulated millisecond, e.g. -i 1000:45
+ *   -q  Quiet, suppress console output.
+ *   -t  Print the pin, servo and sound trace after the run.
+ *   -r  Include the individual PWM steps of fades in the trace.
+ *   -b  Report interrupt blackouts and the IR frames and servo pulses they would spoil.
+ *   -o  Write the trace to a file.
+ *   -g  Compare the trace with a golden trace file, exit status 1 if it differs.
+ *   -j  Jitter allowed against the golden trace in milliseconds (default 1).
+ *   -e  EEPROM image loaded at power on, if it exists, and saved after the run.
+ *   -f  Type L then stream a scene file (tools/ahkscene.py) at 115200 baud from a simulated
+ *       millisecond, sending each part as the firmware's "Stream want" allows, as
+ *       tools/ahkscene.py send does.
+ *   -x  Send console bytes, in hex, at 115200 baud from a simulated millisecond, e.g. link
+ *       frames from tools/ahklink.py --hex.
+ */
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include <Arduino.h>
+#include "ahklog.h"
+#include "hal_sim.h"
+
+static void usage(const char *program) {
+  fprintf(stderr, "Usage: %s [-d seconds] [-s loop-us] [-a ack-us] [-k ms:key] [-i ms:hex] [-q] [-t] [-r] [-b]\n"
+    "          [-o trace-file] [-g golden-file] [-j jitter-ms] [-e eeprom-file] [-f ms:scene-file]\n"
+    "          [-x ms:hex-bytes]\n", program);
+  exit(2);
+}
+
+#define SIM_BYTE_US 87 ///< A console byte at 115200 baud.
+
+//
+// Scene file host (-f). Reads "Stream want" from the console log as the
+// firmware writes it, binary frames or AHK_LOG_TEXT lines, and sends the
+// file up to each allowance.
+//
+static std::vector<uint8_t> streamData;
+static size_t streamSent = 0;
+static uint64_t streamFreeAt = 0; ///< Simulated time the console line is next free.
+static bool streamInFrame = false; ///< Between a LOG_MARK and the end of its frame.
+static bool streamEscaped = false; ///< The last frame byte was LOG_ESC.
+static std::vector<uint8_t> streamFrame; ///< Unescaped frame bytes after LOG_MARK.
+static std::string streamLine; ///< Text line being written.
+
+static void streamAllow(unsigned long allow) {
+  uint64_t at = std::max(simMicros(), streamFreeAt);
+
+  for(; streamSent < allow && streamSent < streamData.size(); ++streamSent) {
+    at += SIM_BYTE_US;
+    simInputAt(at, false, streamData[streamSent]);
+  }
+  streamFreeAt = at;
+}
+
+static unsigned long streamVarint(size_t &at) {
+  unsigned long value = 0;
+
+  for(unsigned shift = 0; at < streamFrame.size(); shift += 7) {
+    uint8_t b = streamFrame[at++];
+    value |= (unsigned long)(b & 0x7F) << shift;
+    if(!(b & 0x80)) {
+      break;
+    }
+  }
+  return value;
+}
+
+// Frames are read by their length, LOG_MARK is only looked for between them
+// and, as a frame cut short, within one.
+static void streamTap(uint8_t c) {
+  if(c == LOG_MARK) {
+    streamInFrame = true;
+    streamEscaped = false;
+    streamFrame.clear();
+    return;
+  }
+
+  if(!streamInFrame) {
+    unsigned long allow;
+    if(c != '\n') {
+      streamLine += (char)c;
+      return;
+    }
+    if(sscanf(streamLine.c_str(), "Stream want %lu", &allow) == 1) {
+      streamAllow(allow);
+    }
+    streamLine.clear();
+    return;
+  }
+
+  if(c == LOG_ESC && !streamEscaped) {
+    streamEscaped = true;
+    return;
+  }
+  streamFrame.push_back(streamEscaped ? c ^ LOG_ESC_FLIP : c);
+  streamEscaped = false;
+
+  // Complete once the time, arguments and any suppressed count have ended.
+  if(streamFrame.size() < 3) {
+    return;
+  }
+  uint8_t info = streamFrame[1];
+  size_t varints = 1 + (info & ~LOG_SUPPRESSED) + ((info & LOG_SUPPRESSED) ? 1 : 0);
+  size_t ended = std::count_if(streamFrame.begin() + 2, streamFrame.end(), [](uint8_t b) { return !(b & 0x80); });
+  if(ended < varints) {
+    return;
+  }
+
+  if(streamFrame[0] == LOG_STREAM_WANT && (info & ~LOG_SUPPRESSED) == 1) {
+    size_t at = 2;
+    streamVarint(at); // Time.
+    streamAllow(streamVarint(at) >> 1);
+  }
+  streamInFrame = false;
+}
+
+static bool streamFile(uint64_t us, const char *path) {
+  FILE *file = fopen(path, "rb");
+  if(!file) {
+    return false;
+  }
+
+  for(int c; (c = fgetc(file)) != EOF;) {
+    streamData.push_back((uint8_t)c);
+  }
+  fclose(file);
+
+  simInputAt(us, false, 'L');
+  streamFreeAt = us;
+  simConsoleTap(streamTap);
+  return true;
+}
+
+static bool sendHex(uint64_t us, const char *hex) {
+  for(; hex[0] && hex[1]; hex += 2, us += SIM_BYTE_US) {
+    char pair[3] = {hex[0], hex[1], 0};
+    char *end;
+    int b = (int)strtol(pair, &end, 16);
+    if(*end) {
+      return false;
+    }
+    simInputAt(us, false, b);
+  }
+  return !hex[0];
+}
+
+int main(int argc, char *argv[]) {
+  double duration = 10;
+  uint64_t loopCost = 100;
+  bool trace = false;
+  bool ramps = false;
+  bool blackouts = false;
+  const char *output = nullptr;
+  const char *golden = nullptr;
+  const char *eeprom = nullptr;
+  double jitter = 1;
+
+  for(int i = 1; i < argc; ++i) {
+    const char *opt = argv[i];
+    const char *arg = i + 1 < argc ? argv[i + 1] : nullptr;
+    const char *colon = arg ? strchr(arg, ':') : nullptr;
+
+    if(!strcmp(opt, "-q")) {
+      simQuiet = true;
+    } else if(!strcmp(opt, "-t")) {
+      trace = true;
+    } else if(!strcmp(opt, "-r")) {
+      ramps = true;
+    } else if(!strcmp(opt, "-b")) {
+      blackouts = true;
+    } else if(!arg) {
+      usage(argv[0]);
+    } else if(!strcmp(opt, "-d")) {
+      duration = atof(arg); ++i;
+    } else if(!strcmp(opt, "-s")) {
+      loopCost = strtoull(arg, nullptr, 10); ++i;
+    } else if(!strcmp(opt, "-o")) {
+      output = arg; ++i;
+    } else if(!strcmp(opt, "-g")) {
+      golden = arg; ++i;
+    } else if(!strcmp(opt, "-e")) {
+      eeprom = arg; ++i;
+    } else if(!strcmp(opt, "-j")) {
+      jitter = atof(arg); ++i;
+    } else if(!strcmp(opt, "-a")) {
+      simSetAckDelay(strtoull(arg, nullptr, 10)); ++i;
+    } else if(!strcmp(opt, "-k") && colon) {
+      simInputAt(strtoull(arg, nullptr, 10) * 1000, false, colon[1]); ++i;
+    } else if(!strcmp(opt, "-i") && colon) {
+      simInputAt(strtoull(arg, nullptr, 10) * 1000, true, (int)strtol(colon + 1, nullptr, 16)); ++i;
+    } else if(!strcmp(opt, "-f") && colon) {
+      if(!streamFile(strtoull(arg, nullptr, 10) * 1000, colon + 1)) {
+        perror(colon + 1);
+        exit(2);
+      }
+      ++i;
+    } else if(!strcmp(opt, "-x") && colon) {
+      if(!sendHex(strtoull(arg, nullptr, 10) * 1000, colon + 1)) {
+        usage(argv[0]);
+      }
+      ++i;
+    } else {
+      usage(argv[0]);
+    }
+  }
+
+  if(!loopCost) {
+    usage(argv[0]);
+  }
+
+  if(eeprom) {
+    simLoadEeprom(eeprom);
+  }
+
+  setup();
+
+  uint64_t end = simMicros() + (uint64_t)(duration * 1000000);
+  uint64_t loops = 0;
+  double total = 0, fastest = 1e9, slowest = 0;
+
+  while(simMicros() < end) {
+    auto start = std::chrono::steady_clock::now();
+    loop();
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    total += ns;
+    fastest = ns < fastest ? ns : fastest;
+    slowest = ns > slowest ? ns : slowest;
+    ++loops;
+
+    simAdvance(loopCost);
+  }
+
+  if(trace) {
+    simPrintTrace(stdout, ramps);
+  }
+
+  if(output) {
+    FILE *out = fopen(output, "w");
+    if(!out) {
+      perror(output);
+      return 2;
+    }
+    simPrintTrace(out, ramps);
+    fclose(out);
+  }
+
+  fprintf(stderr, "Simulated %.3f s in %llu loops (%.0f loops per simulated second)\n",
+    duration, (unsigned long long)loops, loops / duration);
+  fprintf(stderr, "Host loop() time: min %.0f ns, mean %.0f ns, max %.0f ns (%.0f loops per host second)\n",
+    fastest, total / loops, slowest, loops / (total / 1e9));
+  fprintf(stderr, "Recorded %zu pin, servo and sound changes\n", simTrace().size());
+  if(simEepromWrites()) {
+    fprintf(stderr, "EEPROM bytes written: %lu\n", simEepromWrites());
+  }
+  if(eeprom && !simSaveEeprom(eeprom)) {
+    perror(eeprom);
+    return 2;
+  }
+  if(simAsleep()) {
+    fprintf(stderr, "Asleep %.1f%% of simulated time, awake %.1f%% at %llu us a loop\n",
+      100.0 * simAsleep() / simMicros(), 100.0 - 100.0 * simAsleep() / simMicros(), (unsigned long long)loopCost);
+  }
+  if(blackouts) {
+    simPrintBlackouts(stderr, simMicros());
+  }
+
+  if(golden) {
+    FILE *in = fopen(golden, "r");
+    if(!in) {
+      perror(golden);
+      return 2;
+    }
+    bool match = simCompareTrace(in, jitter, ramps);
+    fclose(in);
+    return match ? 0 : 1;
+  }
+
+  return 0;
+}
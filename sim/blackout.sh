@@ -0,0 +1,29 @@
+#!/bin/sh
+#
+# Sound transport benchmark. Plays cut scene 01 on the native build with each
+# DFPlayer transport and reports how long interrupts are held off, and how
+# many IR frames (a key held on the remote) and servo pulses that would spoil.
+#
+# Usage: sim/blackout.sh
+#
+# Set PROGRAM and PROGRAM_TIMER0 to use already built native programs.
+#
+cd "$(dirname "$0")/.." || exit 2
+
+PROGRAM=${PROGRAM:-.pio/build/native/program}
+PROGRAM_TIMER0=${PROGRAM_TIMER0:-.pio/build/native_timer0/program}
+
+if [ -z "${PROGRAM##.pio/*}" ]; then
+  pio run -s -e native || exit 2
+fi
+if [ -z "${PROGRAM_TIMER0##.pio/*}" ]; then
+  pio run -s -e native_timer0 || exit 2
+fi
+
+run() {
+  name=$1; shift
+  "$@" -q -b -d 135 -k 1000:1 2>&1 | grep -E "^(Interrupt|IR|Servo)" | sed "s/^/$name: /"
+}
+
+run softserial "$PROGRAM"
+run timer0 "$PROGRAM_TIMER0"
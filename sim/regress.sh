@@ -0,0 +1,50 @@
+#!/bin/sh
+#
+# Timing regression suite. Replays each scene on the native build in
+# simulated time and compares the pin, servo and sound trace with the golden
+# trace in sim/golden, allowing JITTER ms of difference per change. Scene 1
+# is also streamed over the console (tools/ahkscene.py), sent only as far as
+# the firmware asks.
+#
+# Usage: sim/regress.sh [--update]
+#
+#   --update  Rewrite the golden traces from this build (after an intended change).
+#
+# Set PROGRAM to use an already built native program.
+#
+cd "$(dirname "$0")/.." || exit 2
+
+PROGRAM=${PROGRAM:-.pio/build/native/program}
+JITTER=${JITTER:-1}
+GOLDEN=sim/golden
+UPDATE=0
+failed=0
+
+[ "$1" = "--update" ] && UPDATE=1
+
+if [ -z "${PROGRAM##.pio/*}" ]; then
+  pio run -s -e native || exit 2
+fi
+
+run() {
+  name=$1; shift
+
+  if [ $UPDATE -eq 1 ]; then
+    out=$("$PROGRAM" -q "$@" -o "$GOLDEN/$name.trace" 2>&1)
+  else
+    out=$("$PROGRAM" -q "$@" -g "$GOLDEN/$name.trace" -j "$JITTER" 2>&1) || failed=1
+  fi
+  echo "$out" | sed "s/^/$name: /"
+}
+
+run power_on -d 20 -k 1000:'*'
+run power_off -d 35 -k 1000:'*' -k 20000:'*'
+run cut_scene_01 -d 135 -k 1000:1
+
+scene=$(mktemp) || exit 2
+python3 tools/ahkscene.py convert src/ahkscenes.cpp "$scene" --timings CUT_SCENE_01_TIMINGS >/dev/null || failed=1
+run streamed_scene_01 -d 135 -f 1000:"$scene"
+rm -f "$scene"
+
+[ $failed -eq 0 ] || echo "Timing regression FAILED"
+exit $failed
@@ -8,10 +8,15 @@
  * @copyright Copyright (c) 2022 John Scott.
  */
 #include <Arduino.h>
-#include <jled.h>
 #include <Servo.h>
 #include <ServoEasing.hpp> 
 #include "aerialhk.h"
+#include "ahkcurve.h"
+#include "ahkleds.h"
+#include "ahkmotion.h"
+#include "ahkout.h"
+#include "ahksettings.h"
+#include "ahkstats.h"
 #include "pinout.h"
 
 // Servos...
@@ -20,11 +25,20 @@ ServoEasing thrustServoR;
 ServoEasing turnServo;
 ServoEasing tiltServo;
 
-auto plasmaLed = JLed(PIN_PLASMA_GUN).Off();
-auto landingLed = JLed(PIN_LANDING_LIGHTS).Off();
+// Motion curves...
+static constexpr struct CurveKey TURN_SCAN_KEYS[] = {
+  {0, AHK_TURN_CENTRE}, {1200, 60}, {2000, 55}, {3500, 125}, {4300, 130}, {5500, AHK_TURN_CENTRE}
+};
+BAKE_CURVE(TURN_SCAN, 50, TURN_SCAN_KEYS);
+
+static constexpr struct CurveKey TILT_DIVE_KEYS[] = {
+  {0, AHK_TILT_CENTRE}, {600, 165}, {1800, 175}, {3000, AHK_TILT_CENTRE}
+};
+BAKE_CURVE(TILT_DIVE, 50, TILT_DIVE_KEYS);
 
 static int tiltAngle = AHK_TILT_CENTRE;
 static int turnAngle = AHK_TURN_CENTRE;
+static bool landingOnOff = false; ///< Landing lights breathing, off again when the effect ends.
 
 
 //
@@ -44,7 +58,12 @@ void setupAHK() {
   pinMode(PIN_PLASMA_GUN, OUTPUT);
   plasmaGunOff();
 
-  // HK thrusters...
+  // HK thrusters, trimmed from the settings before the first pulse...
+  thrustServoL.setTrim(settings.thrustTrim);
+  thrustServoR.setTrim(-settings.thrustTrim);
+  tiltServo.setTrim(settings.tiltTrim);
+  turnServo.setTrim(settings.turnTrim);
+
   thrustServoL.attach(PIN_THRUST_SERVO_L, AHK_THRUST_CENTRE);
   thrustServoL.setSpeed(AHK_THRUST_SPEED);
   
@@ -66,8 +85,31 @@ void setupAHK() {
 // AHK Loop Handler...
 //
 void loopAHK() {
-  plasmaLed.Update();
-  landingLed.Update();
+  STATS_BEGIN();
+  // Effects started by this pass's cues and commands take their first step here.
+  if((ledsUpdate() & OUT_LANDING_LIGHTS) && landingOnOff) {
+    landingOnOff = false;
+    outputsWrite(OUT_LANDING_LIGHTS, 0);
+  }
+  motionUpdate();
+  STATS_END(STATS_LOOP_AHK);
+}
+
+
+//
+// Output transaction. Coincident cues stage their changes, which are then
+// made together: direct lights in one write per port, servo moves as one
+// motion group arriving together, apart from the thruster pair which keeps
+// its own speed.
+//
+void ahkBegin() {
+  outputsBegin();
+  motionBegin();
+}
+
+void ahkCommit() {
+  outputsCommit();
+  motionCommit();
 }
 
 
@@ -75,15 +117,15 @@ void loopAHK() {
 // Tail Lights...
 //
 bool isTailLights() {
-  return digitalRead(PIN_TAIL_LIGHTS);
+  return isOutput(OUT_TAIL_LIGHTS);
 }
 
 void tailLightsOn() {
-  digitalWrite(PIN_TAIL_LIGHTS, true);
+  outputsWrite(OUT_TAIL_LIGHTS, OUT_TAIL_LIGHTS);
 }
 
 void tailLightsOff() {
-  digitalWrite(PIN_TAIL_LIGHTS, false);
+  outputsWrite(OUT_TAIL_LIGHTS, 0);
 }
 
 
@@ -91,24 +133,29 @@ void tailLightsOff() {
 // Landing Lights...
 //
 bool isLandingLights() {
-  return digitalRead(PIN_LANDING_LIGHTS);
+  return isOutput(OUT_LANDING_LIGHTS);
 }
 
 void landingLightsOn() {
   if(!isLandingLights()) {
-    landingLed.Reset().FadeOn(1500).Repeat(1).Update();
+    outputsWrite(OUT_LANDING_LIGHTS, OUT_LANDING_LIGHTS);
+    ledEffect(OUT_LANDING_LIGHTS).FadeOn(1500);
   }
 }
 
 void landingLightsOnOff() {
   if(!isLandingLights()) {
-    landingLed.Reset().Breathe(1500,7000,1500).Repeat(1).Update();
+    outputsWrite(OUT_LANDING_LIGHTS, OUT_LANDING_LIGHTS);
+    landingOnOff = true;
+    ledEffect(OUT_LANDING_LIGHTS).Breathe(1500,7000,1500);
   }
 }
 
 void landingLightsOff() {
   if(isLandingLights()) {
-    landingLed.Reset().FadeOff(1500).Repeat(1).Update();
+    outputsWrite(OUT_LANDING_LIGHTS, 0);
+    landingOnOff = false;
+    ledEffect(OUT_LANDING_LIGHTS).FadeOff(1500);
   }
 }
 
@@ -117,15 +164,15 @@ void landingLightsOff() {
 // Search Lights...
 //
 bool isSearchLights() {
-  return digitalRead(PIN_SEARCH_LIGHTS);
+  return isOutput(OUT_SEARCH_LIGHTS);
 }
 
 void searchLightsOn() {
-  digitalWrite(PIN_SEARCH_LIGHTS, true);
+  outputsWrite(OUT_SEARCH_LIGHTS, OUT_SEARCH_LIGHTS);
 }
 
 void searchLightsOff() {
-  digitalWrite(PIN_SEARCH_LIGHTS, false);
+  outputsWrite(OUT_SEARCH_LIGHTS, 0);
 }
 
 
@@ -133,27 +180,31 @@ void searchLightsOff() {
 // Plasma Gun...
 //
 bool isPlasmaGun() {
-  return plasmaLed.IsRunning();
+  return isOutput(OUT_PLASMA_GUN);
 }
 
 void plasmaGunOn() {
-  plasmaLed.Reset().Blink(50,50).Forever().Update();
+  outputsWrite(OUT_PLASMA_GUN, OUT_PLASMA_GUN);
+  ledEffect(OUT_PLASMA_GUN).Blink(50,50).Forever();
 }
 
 void plasmaGunOff() {
-  plasmaLed.Reset().Off().Repeat(1).Update();
+  outputsWrite(OUT_PLASMA_GUN, 0);
+  ledEffect(OUT_PLASMA_GUN).Off();
 }
 
 void plasmaGunOn200() {
-  plasmaLed.Reset().Blink(50,50).Repeat(2).Update();
+  ledEffect(OUT_PLASMA_GUN).Blink(50,50).Repeat(2);
 }
 
 //
 // Thruster Servos...
 //
-void thrustTo(int thrust, int speed = AHK_THRUST_SPEED) {
-  thrustServoL.startEaseTo(thrust);
-  thrustServoR.startEaseTo(180-thrust);
+void thrustTo(int thrust, int speed) {
+  motionBegin(true); // The pair arrive together, at their own speed.
+  motionMove(thrustServoL, thrust, speed);
+  motionMove(thrustServoR, 180-thrust, speed);
+  motionCommit();
 }
 
 void thrustMin() {
@@ -179,15 +230,19 @@ void thrustMax() {
 void thrustLeft() {
   int thrustL = AHK_THRUST_CENTRE - AHK_THRUST_OFFSET;
   int thrustR = AHK_THRUST_CENTRE + AHK_THRUST_OFFSET; 
-  thrustServoL.startEaseTo(thrustL);
-  thrustServoR.startEaseTo(180-thrustR);
+  motionBegin(true);
+  motionMove(thrustServoL, thrustL, AHK_THRUST_SPEED);
+  motionMove(thrustServoR, 180-thrustR, AHK_THRUST_SPEED);
+  motionCommit();
 }
 
 void thrustRight() {
   int thrustL = AHK_THRUST_CENTRE + AHK_THRUST_OFFSET;
   int thrustR = AHK_THRUST_CENTRE - AHK_THRUST_OFFSET;
-  thrustServoL.startEaseTo(thrustL);
-  thrustServoR.startEaseTo(180-thrustR);
+  motionBegin(true);
+  motionMove(thrustServoL, thrustL, AHK_THRUST_SPEED);
+  motionMove(thrustServoR, 180-thrustR, AHK_THRUST_SPEED);
+  motionCommit();
 }
 
 
@@ -205,7 +260,7 @@ void tiltTo(int degrees) {
     degrees = AHK_TILT_MAX;
   }
 
-  tiltServo.startEaseTo(degrees);
+  motionMove(tiltServo, degrees, AHK_TILT_SPEED);
   tiltAngle = degrees;
 }
 
@@ -221,18 +276,22 @@ void tiltBackward() {
   tiltTo(AHK_TILT_MIN);
 }
 
+void tiltDive() {
+  tiltAngle = motionCurve(tiltServo, TILT_DIVE.bytes);
+}
+
 
 //
 // Turn Servo...
 //
-void turnTo(int degrees, int speed = AHK_TURN_SPEED) {
+void turnTo(int degrees, int speed) {
   if(degrees < AHK_TURN_MIN) {
     degrees = AHK_TURN_MIN;
   } else if(degrees > AHK_TURN_MAX) {
     degrees = AHK_TURN_MAX;
   }
 
-  turnServo.startEaseTo(degrees,speed);
+  motionMove(turnServo, degrees, speed);
   turnAngle = degrees;
 }
 
@@ -255,3 +314,45 @@ void turnCentre() {
 void turnRight() {
   turnTo(AHK_TURN_MIN);
 }
+
+void turnScan() {
+  turnAngle = motionCurve(turnServo, TURN_SCAN.bytes);
+}
+
+
+//
+// Servo trims, for the unit's mechanical centres. Saved in the settings.
+//
+static int trimBy(signed char &trim, int delta) {
+  int degrees = trim + delta;
+  if(degrees < -SETTINGS_TRIM_MAX) {
+    degrees = -SETTINGS_TRIM_MAX;
+  } else if(degrees > SETTINGS_TRIM_MAX) {
+    degrees = SETTINGS_TRIM_MAX;
+  }
+
+  if(degrees != trim) {
+    trim = degrees;
+    settingsChanged();
+  }
+  return degrees;
+}
+
+int thrustTrim(int delta) {
+  int trim = trimBy(settings.thrustTrim, delta);
+  thrustServoL.setTrim(trim, true);
+  thrustServoR.setTrim(-trim, true);
+  return trim;
+}
+
+int tiltTrim(int delta) {
+  int trim = trimBy(settings.tiltTrim, delta);
+  tiltServo.setTrim(trim, true);
+  return trim;
+}
+
+int turnTrim(int delta) {
+  int trim = trimBy(settings.turnTrim, delta);
+  turnServo.setTrim(trim, true);
+  return trim;
+}
@@ -7,12 +7,20 @@
  * 
  * @copyright Copyright (c) 2022 John Scott.
  */
-#include <AsyncTimer.h>
 #define IR_SMALLD_NEC
 #include <IRsmallDecoder.h>
 #include "aerialhk.h"
 #include "ahkctrl.h"
 #include "ahkfx.h"
+#include "ahkinput.h"
+#include "ahklink.h"
+#include "ahklog.h"
+#include "ahkremote.h"
+#include "ahkscene.h"
+#include "ahksched.h"
+#include "ahkstats.h"
+#include "ahkstream.h"
+#include "ahktimeline.h"
 #include "pinout.h"
 
 //
@@ -29,371 +37,240 @@
 #define CTL_FNSTP '!' ///< Func/Stop.
 #define CTL_EQUAL '=' ///< EQ.
 #define CTL_STRPT '/' ///< ST/REPT.
+#define CTL_STATS '?' ///< Dump instrumentation (AHK_STATS builds).
+#define CTL_THRUP 'Q' ///< Thrust trim up (console).
+#define CTL_THRDN 'A' ///< Thrust trim down (console).
+#define CTL_TLTUP 'W' ///< Tilt trim up (console).
+#define CTL_TLTDN 'S' ///< Tilt trim down (console).
+#define CTL_TRNUP 'E' ///< Turn trim up (console).
+#define CTL_TRNDN 'D' ///< Turn trim down (console).
+#define CTL_LOAD 'L' ///< Play a scene file streamed after it (console).
 
 IRsmallDecoder irDecoder(PIN_IR_RECEIVER);
 irSmallD_t irData;
 
 //
-// Cut scene controllers.
+// Turn controller.
 //
-static unsigned long cutSceneTimer = 0;
-static unsigned short cutSceneStep = 0;
-static unsigned short cutSceneControllerId = 0;
-void cutScene01Controller(); ///< Control main cut scene 01.
-
-static unsigned short turnControllerId = 0;
-void startTurnRightRandom();
-void stopTurning();
+static SchedHandle turnControllerId = 0;
 
 
 //
-// Timed effects...
+// IR remote key maps...
 //
-AsyncTimer ATimer; ///< Asynchronous Timer.
-
-struct AsyncTiming {
-  void (*callback)();
-  unsigned long start;
-  unsigned long repeat;
-};
-
-// Macros for AsyncTimings
-#define AT_TIME(START, FN) {FN, START, 0}
-#define AT_THEN_EVERY(START, REPEAT, FN) {FN, START, REPEAT}
-#define END_TIMINGS {0,0,0}
-
-static const struct AsyncTiming POWER_ON[] PROGMEM = {
-  AT_TIME(0, tailLightsOn),
-  AT_TIME(500, playTakeoff),
-  AT_TIME(550, landingLightsOnOff),
-  AT_TIME(5500, searchLightsOn),
-  AT_THEN_EVERY(15000, 30000, playFlyMore),
-  END_TIMINGS
+#if AHK_REMOTE == REMOTE_ELEGOO21
+static constexpr struct IRKey REMOTE_KEYS[] = {
+  {0x45, CTL_POWER}, // Power On/Off
+  {0x47, CTL_FNSTP}, // Func/Stop
+  {0x19, CTL_EQUAL}, // EQ
+  {0x0D, CTL_STRPT}, // ST/REPT
+  {0x46, CTL_VOLUP}, // Vol +
+  {0x15, CTL_VOLDN}, // Vol -
+  {0x44, CTL_REWND}, // |<< (Rewind)
+  {0x40, CTL_PLAYP}, // >|| (Play/Pause)
+  {0x43, CTL_FASTF}, // >>| (Fast Forward)
+  {0x07, CTL_MOVDN}, // V (Down)
+  {0x09, CTL_MOVUP}, // ^ (Up)
+  {0x16, '0'}, {0x0C, '1'}, {0x18, '2'}, {0x5E, '3'}, {0x08, '4'},
+  {0x1C, '5'}, {0x5A, '6'}, {0x42, '7'}, {0x52, '8'}, {0x4A, '9'}
 };
-
-const struct AsyncTiming POWER_OFF[] PROGMEM = {
-  AT_TIME(0, playLanding),
-  AT_TIME(250, blueLightsOff),
-  AT_TIME(250, redLightsOff),
-  AT_TIME(500, tiltLevel),
-  AT_TIME(1000, landingLightsOnOff),
-  AT_TIME(1500, turnCentre),
-  AT_TIME(2000, searchLightsOff),
-  AT_TIME(3500, thrustHover),
-  AT_TIME(10000, tailLightsOff),
-  END_TIMINGS
-};
-
-const struct AsyncTiming CUT_SCENE_01_CTL[] PROGMEM = {
-  AT_TIME(0, tailLightsOn),
-  AT_TIME(0, playScene01),
-  AT_THEN_EVERY(0,10,cutScene01Controller),
-  END_TIMINGS
+#elif AHK_REMOTE == REMOTE_KEYES17
+static constexpr struct IRKey REMOTE_KEYS[] = {
+  {0x16, CTL_POWER}, // *
+  {0x0D, CTL_EQUAL}, // #
+  {0x1C, CTL_PLAYP}, // OK
+  {0x08, CTL_REWND}, // <
+  {0x5A, CTL_FASTF}, // >
+  {0x52, CTL_MOVDN}, // V
+  {0x18, CTL_MOVUP}, // ^
+  {0x19, '0'}, {0x45, '1'}, {0x46, '2'}, {0x47, '3'}, {0x44, '4'},
+  {0x40, '5'}, {0x43, '6'}, {0x07, '7'}, {0x15, '8'}, {0x09, '9'}
 };
+#else
+#error "Unknown AHK_REMOTE profile"
+#endif
 
-const struct AsyncTiming CUT_SCENE_01[] PROGMEM = {
-  AT_TIME(2000, landingLightsOnOff),
-  AT_TIME(5500, searchLightsOn),
-
-  AT_TIME(6000, thrustForward),
-  AT_TIME(6000, tiltForward),
-  AT_TIME(9232, blueLightsFlashOn),
-  AT_TIME(9332, blueLightsOff),
-  AT_TIME(9300, redLightsFlashOn),
-  AT_TIME(9375, redLightsOff),
-
-  AT_TIME(13000, thrustHover),
-  AT_TIME(13000, tiltBackward),
-
-  AT_TIME(14000, thrustRight),
-  AT_TIME(14000, turnRight),
-  AT_TIME(16000, thrustHover),
-  AT_TIME(16500, blueLightsFlashOn),
-  AT_TIME(16575, blueLightsOff),
-  AT_TIME(18000, redLightsFlashOn),
-  AT_TIME(18075, redLightsOff),
-  AT_TIME(18575, blueLightsFlashOn),
-  AT_TIME(18650, blueLightsOff),
-  AT_TIME(19250, redLightsFlashOn),
-  AT_TIME(19325, redLightsOff),
-  AT_TIME(19575, blueLightsFlashOn),
-  AT_TIME(19650, blueLightsOff),
-
-  AT_TIME(20000, thrustForward),
-  AT_TIME(20000, tiltForward),
-  AT_TIME(21700, blueLightsFlashOn),
-  AT_TIME(21800, blueLightsOff),
-  AT_TIME(22700, redLightsFlashOn),
-  AT_TIME(22775, redLightsOff),
-  AT_TIME(23060, redLightsFlashOn),
-  AT_TIME(23135, redLightsOff),
-
-  AT_TIME(24000, thrustLeft),
-  AT_TIME(24000, turnLeft),
-  AT_TIME(26000, thrustForward),
-
-  AT_TIME(28000, thrustHover),
-  AT_TIME(28000, tiltLevel),
-
-  AT_TIME(32000, thrustRight),
-  AT_TIME(32000, turnRight),
-  AT_TIME(34000, thrustHover),
-
-  AT_TIME(36000, thrustForward),
-  AT_TIME(36000, tiltForward),
-  AT_TIME(38600, redLightsFlashOn),
-  AT_TIME(38675, redLightsOff),
-
-  AT_TIME(40000, thrustHover),
-  AT_TIME(40000, tiltBackward),
-
-  AT_TIME(40000, startTurnRightRandom),
-  AT_TIME(40500, blueLightsFlashOn),
-  AT_TIME(41470, blueLightsOff),
-  AT_TIME(41900, redLightsFlashOn),
-  AT_TIME(42500, redLightsOff),
-  AT_TIME(42660, blueLightsFlashOn),
-  AT_TIME(43000, blueLightsOff),
-  AT_TIME(44400, blueLightsFlashOn),
-  AT_TIME(44500, redLightsFlashOn),
-  AT_TIME(45500, blueLightsOff),
-  AT_TIME(45700, redLightsOff),
-  AT_TIME(45700, blueLightsFlashOn),
-  AT_TIME(46700, blueLightsOff),
-  AT_TIME(46700, redLightsFlashOn),
-  AT_TIME(48300, redLightsOff),
-  AT_TIME(49000, blueLightsFlashOn),
-  AT_TIME(49000, redLightsOn),
-  AT_TIME(49750, redLightsOff),
-  AT_TIME(50000, blueLightsOff),
-  AT_TIME(50000, redLightsFlashOn),
-  AT_TIME(50700, blueLightsFlashOn),
-  AT_TIME(51300, blueLightsOff),
-  AT_TIME(51700, blueLightsFlashOn),
-  AT_TIME(52600, blueLightsOff),
-  AT_TIME(52600, redLightsOn),
-  AT_TIME(52600, blueLightsOn),
-  AT_TIME(53000, stopTurning),
-  AT_TIME(55000, redLightsOff),
-  AT_TIME(55000, blueLightsOff),
-  AT_TIME(56000, thrustForward),
-  AT_TIME(56000, tiltForward),
-
-  AT_TIME(60000, thrustHover),
-  AT_TIME(60000, tiltBackward),
-  AT_TIME(63400, blueLightsFlashOn),
-  AT_TIME(63700, blueLightsOff),
-  AT_TIME(63700, redLightsOn),
-  AT_TIME(64500, redLightsOff),
-  AT_TIME(67200, redLightsOn),
-  AT_TIME(68500, blueLightsOn),
-  AT_TIME(69000, startTurnRightRandom),
-  AT_TIME(69500, redLightsOff),
-  AT_TIME(70000, blueLightsOff),
-  AT_TIME(70000, redLightsFlashOn),
-  AT_TIME(71100, redLightsOn),
-  AT_TIME(71100, blueLightsOn),
-  AT_TIME(72000, redLightsOff),
-  AT_TIME(72000, blueLightsOff),
-  AT_TIME(73000, redLightsFlashOn),
-  AT_TIME(75700, blueLightsFlashOn),
-  AT_TIME(77000, blueLightsOff),
-  AT_TIME(78000, blueLightsFlashOn),
-  AT_TIME(80000, redLightsOff),
-  AT_TIME(80200, blueLightsOff),
-  AT_TIME(80400, redLightsOn),
-  AT_TIME(80400, blueLightsOn),
-  AT_TIME(81800, blueLightsOff),
-  AT_TIME(83700, redLightsOff),
-  AT_TIME(83800, blueLightsFlashOn),
-  AT_TIME(85900, blueLightsOff),
-  AT_TIME(85900, redLightsOn),
-  AT_TIME(87000, stopTurning),
-  AT_TIME(87300, redLightsOff),
-
-  AT_TIME(87300, tiltForward),
-  AT_TIME(87400, turnLeft),
-  AT_TIME(87500, thrustMin),
-  AT_TIME(87500, searchLightsOff),
-  AT_TIME(88500, tailLightsOff),
-  AT_TIME(89000, redLightsOn),
-  AT_TIME(89000, blueLightsOn),
-  AT_TIME(91000, redLightsOff),
-  AT_TIME(91500, blueLightsOff),
-
-  AT_TIME(91500, thrustBack),
-  AT_TIME(91500, tiltLevel),
-  AT_TIME(91500, tailLightsOn),
-  AT_TIME(91500, landingLightsOnOff),
-  AT_TIME(93000, turnCentre),
-  AT_TIME(93000, thrustHover),
-  AT_TIME(93500, searchLightsOn),
-
-  AT_TIME(95000, thrustLeft),
-  AT_TIME(95500, turnLeft),
-  AT_TIME(97000, thrustHover),
-  AT_TIME(99000, thrustForward),
-  AT_TIME(99250, tiltForward),
-  AT_TIME(100000, blueLightsOn),
-  AT_TIME(100000, redLightsOn),
-
-  AT_TIME(102000, thrustRight),
-  AT_TIME(102000, turnRight),
-  AT_TIME(104500, thrustForward),
-
-  AT_TIME(106000, thrustLeft),
-  AT_TIME(106000, turnLeft),
-  AT_TIME(108500, thrustForward),
-
-  AT_TIME(110000, thrustRight),
-  AT_TIME(110000, turnRight),
-  AT_TIME(112500, thrustForward),
-
-  AT_TIME(114000, thrustLeft),
-  AT_TIME(114000, turnLeft),
-  AT_TIME(116500, thrustForward),
-
-  AT_TIME(118000, thrustRight),
-  AT_TIME(118000, turnRight),
-  AT_TIME(120500, thrustForward),
-
-  AT_TIME(121000, blueLightsOff),
-  AT_TIME(121000, redLightsOff),
-  AT_TIME(121500, tiltLevel),
-  AT_TIME(121500, landingLightsOnOff),
-  AT_TIME(122000, stopTurning),
-  AT_TIME(122500, turnCentre),
-  AT_TIME(123500, thrustHover),
-  AT_TIME(124000, searchLightsOff),
-  AT_TIME(130000, tailLightsOff),
-  END_TIMINGS
-};
-
-
-static char translateIR(long value) {
-  char cmd='\0';
-
-  switch(value) {
-    case 0xFFFFFFFF: // Ignore Repeat
-      Serial.println(value);
-      break;  
-
-    case 0x45: // Power On/Off
-      cmd = CTL_POWER;
-      break;
-      
-    case 0x47: // Func/Stop
-      cmd = CTL_FNSTP;
-      break;
-
-    case 0x19: // EQ
-      cmd = CTL_EQUAL;
-      break;
+static_assert(irKeysUnique(REMOTE_KEYS), "REMOTE_KEYS maps an IR code twice");
+static constexpr struct IRMap IR_MAP PROGMEM = buildIRMap(REMOTE_KEYS);
 
-    case 0xD: // ST/REPT
-      cmd = CTL_STRPT;
-      break;
+static char translateIR(unsigned char code) {
+  char cmd = pgm_read_byte(&IR_MAP.cmds[code]);
 
-    case 0x46: // Vol +
-      cmd = CTL_VOLUP;
-      break;
+  if(!cmd) {
+    logEvent(LOG_IR_ERROR, code); // Rate limited, repeats are counted.
+  }
 
-    case 0x15: // Vol -
-      cmd = CTL_VOLDN;
-      break;
-  
-    case 0x44: // |<< (Rewind)
-      cmd = CTL_REWND;
-      break;
+  return cmd;
+}
 
-    case 0x40: // >|| (Play/Pause)
-      cmd = CTL_PLAYP;
-      break;
 
-    case 0x43: // >>| (Fast Forward)
-      cmd = CTL_FASTF;
-      break;
+//
+// Shared scene player. Starting a scene pre-empts any scene already running.
+//
+// With AHK_SOUND_SYNC a scene with a soundtrack holds its cues until the
+// DFPlayer acknowledges the play command, so time 0 is when the track starts
+// rather than when it was asked for. The wait is reported on the console.
+// AHK_SOUND_LEAD adds the unit's delay from "OK" to audible sound. It is
+// an offset only: the DFPlayer reports position in whole seconds, too
+// coarse to stretch the scene clock by.
+//
+#ifndef AHK_SOUND_SYNC
+#define AHK_SOUND_SYNC 1 ///< Start scene cues when the soundtrack starts.
+#endif
+
+#ifndef AHK_SOUND_LEAD
+#define AHK_SOUND_LEAD 0 ///< Milliseconds from the DFPlayer's "OK" until the track is heard.
+#endif
+
+static const uint8_t *syncCues = 0; ///< Scene waiting for its soundtrack.
+static bool syncResume = false; ///< Waiting to resume the paused timeline rather than start it.
+static bool syncPause = false; ///< Play/Pause pressed while waiting, pause once the scene plays.
+static unsigned long syncRequested = 0;
+static struct Scene sceneNow; ///< Scene started last.
+static bool sceneTransport = false; ///< Scene started from a number key, which can be paused and seeked.
+static bool sceneStreamed = false; ///< Scene is being streamed over the console.
+static bool streamCues = false; ///< Streamed scene waiting for its window to fill.
+static bool loadPending = false; ///< CTL_LOAD queued, console bytes after it are the scene.
+
+static void pauseScene();
+
+static void stopScene() {
+  timelineStop();
+  schedCancelAll();
+  turnControllerId = 0;
+  syncCues = 0;
+  syncPause = false;
+  sceneTransport = false;
+  streamCues = false;
+  if(sceneStreamed) {
+    streamStop();
+    sceneStreamed = false;
+  }
+}
 
-    case 0x7: // V (Down)
-      cmd = CTL_MOVDN;
-      break;
+static void startScene(const struct Scene *scene) {
+  stopScene();
+  memcpy_P(&sceneNow, scene, sizeof(sceneNow));
+
+  if(sceneNow.audio) {
+    sceneNow.audio();
+#if AHK_SOUND_SYNC
+    syncCues = sceneNow.cues;
+    syncResume = false;
+    syncRequested = millis();
+    return;
+#endif
+  }
+  timelinePlay(sceneNow.cues, millis(), sceneNow.keyframes);
+}
 
-    case 0x9: // ^ (Up)
-      cmd = CTL_MOVUP;
-      break;
+static void syncScene() {
+  unsigned long at;
 
-    case 0x16:
-      cmd = '0';
-      break;
+  if(!syncCues || isSoundStarting()) {
+    return;
+  }
 
-    case 0xC:
-      cmd = '1';
-      break;
+  bool started = soundStartedAt(at);
+  at += AHK_SOUND_LEAD;
+  if((long)(millis() - at) < 0) {
+    return;
+  }
 
-    case 0x18:
-      cmd = '2';
-      break;
+  logEvent(started ? LOG_SOUND_SYNC : LOG_SOUND_SYNC_FAILED, at - syncRequested);
 
-    case 0x5E:
-      cmd = '3';
-      break;
+  if(syncResume) {
+    timelineResume(at);
+  } else {
+    timelinePlay(syncCues, at, sceneNow.keyframes);
+  }
+  syncCues = 0;
 
-    case 0x8:
-      cmd = '4';
-      break;
+  if(syncPause) {
+    syncPause = false;
+    pauseScene();
+  }
+}
 
-    case 0x1C:
-      cmd = '5';
-      break;
 
-    case 0x5A:
-      cmd = '6';
-      break;
+//
+// Scene transport. While a numbered scene plays, Play/Pause pauses and
+// resumes it and Rewind and Fast Forward seek it in SCENE_SEEK_STEP steps,
+// to whole seconds so the soundtrack can follow. A seek puts each actuator
+// in the state the latest cue for it before the target left it, without
+// firing the cues in between, then plays on from there.
+//
+#define SCENE_SEEK_STEP 10000 ///< Milliseconds a Rewind or Fast Forward moves.
 
-    case 0x42:
-      cmd = '7';
-      break;
+static bool isSceneTransport() {
+  return sceneTransport && (isTimelinePlaying() || isTimelinePaused());
+}
 
-    case 0x52:
-      cmd = '8';
-      break;
+// Waiting for the soundtrack before a numbered scene starts or resumes.
+static bool isSceneWaiting() {
+  return sceneTransport && syncCues;
+}
 
-    case 0x4A:
-      cmd = '9';
-      break;
+// Cancel the repeats and turn controller the cues started, holding the timeline.
+static void holdScene() {
+  timelinePause();
+  schedCancelAll();
+  turnControllerId = 0;
+  syncCues = 0;
+  syncPause = false;
+}
 
-    default:
-      Serial.print(F("IR Code Error: "));
-      Serial.println(value, HEX);
+// Rebuild the state at position and play on from there, once the soundtrack
+// has caught up.
+static void resumeScene(unsigned long position, bool seek) {
+  timelineSeek(position, ACT_SOUND);
+  if(!sceneNow.audio) {
+    timelineResume(millis());
+    return;
   }
 
-  return cmd;
+  if(seek) {
+    seekSound(position / 1000);
+  } else {
+    resumeSound();
+  }
+#if AHK_SOUND_SYNC
+  syncCues = sceneNow.cues;
+  syncResume = true;
+  syncRequested = millis();
+#else
+  timelineResume(millis());
+#endif
 }
 
+static void pauseScene() {
+  if(syncCues) {
+    syncPause = !syncPause; // Still waiting for the soundtrack, pause once it plays.
+    return;
+  }
 
-//
-// Setup timings for given list of timings.
-//
-void setTimings(const struct AsyncTiming timings[]) {
-  struct AsyncTiming t;
-  int i = 0;
-
-  ATimer.cancelAll();
-  cutSceneStep = 0;
-  cutSceneTimer = millis();
+  if(isTimelinePaused()) {
+    logEvent(LOG_SCENE_RESUME, timelinePosition());
+    resumeScene(timelinePosition(), false);
+  } else {
+    holdScene();
+    if(sceneNow.audio) {
+      pauseSound();
+    }
+    logEvent(LOG_SCENE_PAUSE, timelinePosition());
+  }
+}
 
-  do {
-    memcpy_P(&t, &timings[i], sizeof(t));
+static void seekScene(long step) {
+  long position = (long)(timelinePosition() / 1000 * 1000) + step;
 
-    if(t.callback) {
-      ATimer.setTimeout(t.callback, t.start);
+  if(position < 0) {
+    position = 0;
+  }
 
-      if(t.repeat) {
-        ATimer.delay(cutSceneControllerId = ATimer.setInterval(t.callback,t.repeat),t.start);
-      }
-    }
-    ++i;
-  } while(t.callback);
+  holdScene();
+  logEvent(LOG_SCENE_SEEK, position);
+  resumeScene(position, true);
 }
 
 
@@ -413,30 +290,94 @@ void resetAHKCtrl() {
 }
 
 
+//
+// Number keys play the registered scene, or stop sound effects and any
+// running scene if nothing is registered (e.g. 0).
+//
+static void selectScene(unsigned char number) {
+  const struct Scene *scene = &SCENES[number];
+
+  if(!pgm_read_ptr(&scene->cues)) {
+    stopScene();
+    stopPlaying();
+    return;
+  }
+
+  logEvent(LOG_SCENE, number); // Decoded with the scene's name.
+
+  resetAHKCtrl();
+  startScene(scene);
+  sceneTransport = true;
+}
+
+
+//
+// CTL_LOAD plays a scene streamed over the console (see ahkstream.h). Its
+// cues start once the first window has arrived, so a slow host is less
+// likely to leave the scene waiting. The console carries only the scene
+// until it ends, IR keys still work and stopping the scene abandons it.
+//
+static void loadScene() {
+  loadPending = false;
+  stopScene();
+  resetAHKCtrl();
+  streamBegin();
+  sceneStreamed = true;
+  streamCues = true;
+}
+
+static void playStream() {
+  if(streamCues && streamReady()) {
+    timelineStream(millis());
+    streamCues = false;
+  }
+}
+
+
 void setupAHKCtrl() {
   Serial.println(F("AHK Controller Online"));
 }
 
 
-void loopAHKCtrl() {
-  char cmd = '\0';
+//
+// Queue every command waiting on the console and IR receiver, so neither
+// source can starve the other. Console bytes wait while a link frame (see
+// ahklink.h) is held, so each frame is made in a loop pass of its own.
+//
+static void pollInputs() {
+  while(!loadPending && !linkPending() && !isStreaming() && Serial.available()) {
+    int b = Serial.read();
+    if(linkByte(b)) {
+      continue;
+    }
 
-  ATimer.handle();
+    char cmd = toupper(b);
+    if(!isspace(cmd)) {
+      loadPending = inputPush(cmd) && cmd == CTL_LOAD;
+    }
+  }
+  if(isStreaming()) {
+    streamPoll();
+  }
 
-  if(Serial.available()) {
-    cmd = toupper(Serial.read());
-  } else if (irDecoder.dataAvailable(irData) && !irData.keyHeld) {
-    cmd = translateIR(irData.cmd); // Translate to one of the CMD_* values.
+  if(irDecoder.dataAvailable(irData) && !irData.keyHeld) {
+    char cmd = translateIR(irData.cmd); // Translate to one of the CMD_* values.
+    if(cmd) {
+      inputPush(cmd);
+    }
   }
+}
+
 
+static void handleCommand(char cmd) {
   switch(cmd) {
     case CTL_POWER: // Power on/off sequences.
       if(!isTailLights()) {
-        Serial.println(F("Power on"));
-        setTimings(POWER_ON);
+        logEvent(LOG_POWER_ON);
+        startScene(&POWER_ON_SCENE);
       } else {
-        Serial.println(F("Power off"));
-        setTimings(POWER_OFF);
+        logEvent(LOG_POWER_OFF);
+        startScene(&POWER_OFF_SCENE);
       }
       break;
 
@@ -448,37 +389,49 @@ void loopAHKCtrl() {
       volumeDown();
       break;
 
-    case CTL_PLAYP: // Play/Pause == centre model.
-      Serial.println(F("Levelling off"));
+    case CTL_PLAYP: // Play/Pause == pause or resume the scene, or centre model.
+      if(isSceneTransport() || isSceneWaiting()) {
+        pauseScene();
+        break;
+      }
+      logEvent(LOG_LEVEL_OFF);
 
       tiltLevel();
       turnCentre();
       thrustHover();
       break;
 
-    case CTL_REWND: // Rewind == turn left.
-      Serial.println(F("Bank left"));
+    case CTL_REWND: // Rewind == seek the scene back, or turn left.
+      if(isSceneTransport()) {
+        seekScene(-SCENE_SEEK_STEP);
+        break;
+      }
+      logEvent(LOG_BANK_LEFT);
       thrustLeft();
       turnLeft();
       break;
 
-    case CTL_FASTF: // Fast forward == turn right.
-      Serial.println(F("Bank left"));
+    case CTL_FASTF: // Fast forward == seek the scene on, or turn right.
+      if(isSceneTransport()) {
+        seekScene(SCENE_SEEK_STEP);
+        break;
+      }
+      logEvent(LOG_BANK_RIGHT);
       thrustRight();
       turnRight();
       break;
 
     case CTL_MOVDN: // Move down == tilt forward.
       if(getTilt() < AHK_TILT_CENTRE) {
-        Serial.println(F("Hover"));
+        logEvent(LOG_HOVER);
         thrustForward();
         tiltLevel();
       } else if (getTilt() < AHK_TILT_MAX) {
-        Serial.println(F("Fly forward"));
+        logEvent(LOG_FLY_FORWARD);
         thrustForward();
         tiltForward();
       } else {
-        Serial.println(F("Pursuite Mode"));
+        logEvent(LOG_PURSUIT);
         thrustMax();
       }
       break;
@@ -486,7 +439,7 @@ void loopAHKCtrl() {
     case CTL_MOVUP: // Move up == tilt backwards.
       thrustBack();
       if(getTilt() > AHK_TILT_CENTRE) {
-        Serial.println(F("Hover"));
+        logEvent(LOG_HOVER);
         tiltLevel();
       } else {
         tiltBackward();
@@ -495,73 +448,115 @@ void loopAHKCtrl() {
 
     case CTL_FNSTP: // Function/stop == landinglights on/off.
       if(isLandingLights()) {
-        Serial.println(F("Landing lights deactivate"));
+        logEvent(LOG_LANDING_OFF);
         landingLightsOff();
       } else {
-        Serial.println(F("Landing lights activate"));
+        logEvent(LOG_LANDING_ON);
         landingLightsOn();
       }
       break;
 
     case CTL_EQUAL: // Equal (EQ) == Plasma gun on/off.
       if(isPlasmaGun()) {
-        Serial.println(F("Cease fire"));
+        logEvent(LOG_CEASE_FIRE);
         plasmaGunOff();
       } else {
-        Serial.println(F("Commence firing"));
+        logEvent(LOG_FIRING);
         plasmaGunOn();
       }
       break;
 
     case CTL_STRPT: // ST/RPT == Search lights on/off.
       if(isSearchLights()) {
-        Serial.println(F("Suspend search mode"));
+        logEvent(LOG_SEARCH_OFF);
         searchLightsOff();
       } else {
-        Serial.println(F("Search mode activated"));
+        logEvent(LOG_SEARCH_ON);
         searchLightsOn();
       }
       break;
 
-    case '0': // 0 To stop sound effects.
-      stopPlaying();
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+      selectScene(cmd - '0');
+      break;
+
+    case CTL_THRUP: case CTL_THRDN: // Calibrate the unit's servo centres, saved in EEPROM.
+      logEvent(LOG_THRUST_TRIM, thrustTrim(cmd == CTL_THRUP ? 1 : -1));
+      break;
+
+    case CTL_TLTUP: case CTL_TLTDN:
+      logEvent(LOG_TILT_TRIM, tiltTrim(cmd == CTL_TLTUP ? 1 : -1));
+      break;
+
+    case CTL_TRNUP: case CTL_TRNDN:
+      logEvent(LOG_TURN_TRIM, turnTrim(cmd == CTL_TRNUP ? 1 : -1));
       break;
 
-    case '1': // 1 to play cut scene 01.
-      Serial.println(F("Program 01: Search and destroy"));
-      resetAHKCtrl();
-      setTimings(CUT_SCENE_01_CTL);
+    case CTL_LOAD: // L == Play the scene file that follows.
+      loadScene();
       break;
+
+#ifdef AHK_STATS
+    case CTL_STATS: // ? == Dump loop and cue timing counters.
+      statsDump();
+      break;
+#endif
   }
 }
 
 
-void cutScene01Controller() {
-  unsigned long now = millis() - cutSceneTimer;
-  struct AsyncTiming t;
+void loopAHKCtrl() {
+  STATS_BEGIN();
+  struct InputEvent input;
 
-  do {
-    memcpy_P(&t, &CUT_SCENE_01[cutSceneStep], sizeof(t));
+  schedRun();
+  syncScene();
+  pollInputs();
 
-    if(t.callback) {
-      if(now >= t.start) {
-        t.callback();
-        cutSceneStep++;
-      }
-    } else {
-      ATimer.cancel(cutSceneControllerId);
+  while(inputPop(input)) {
+    handleCommand(input.cmd);
+    inputDone(input);
+  }
+  linkApply();
+  playStream();
+
+  STATS_END(STATS_LOOP_CTRL);
+}
+
+
+bool ctrlNextDue(unsigned long &due) {
+  unsigned long at;
+  bool timed = schedNextDue(due);
+
+  // Console bytes pollInputs() would read. An IR frame finishing in its pin
+  // interrupt wakes the CPU, and the decoder can't be asked without taking it.
+  bool unread = !loadPending && !isStreaming() && Serial.available();
+  if(unread || inputPending() || linkPending() || (streamCues && streamReady())) {
+    due = millis();
+    return true;
+  }
+
+  if(syncCues && !isSoundStarting()) {
+    soundStartedAt(at);
+    at += AHK_SOUND_LEAD;
+    if(!timed || (long)(at - due) < 0) {
+      due = at;
     }
-  } while(t.callback && now >= t.start);
+    return true;
+  }
+  return timed;
 }
 
+
 void startTurnRightRandom() {
   stopTurning();
-  turnControllerId = ATimer.setInterval(turnRightRandom, AHK_TURN_INTERVAL);
+  turnControllerId = schedule(turnRightRandom, AHK_TURN_INTERVAL, AHK_TURN_INTERVAL);
 }
 
 void stopTurning() {
   if(turnControllerId) {
-    ATimer.cancel(turnControllerId);
+    schedCancel(turnControllerId);
     turnControllerId = 0;
   }
 }
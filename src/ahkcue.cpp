@@ -0,0 +1,73 @@
+/**
+ * @file ahkcue.cpp
+ * @author John Scott
+ * @brief Aerial Hunter-Killer (AHK) Packed Cue Reader
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#include <Arduino.h>
+#include "ahkcue.h"
+
+static const uint8_t NO_CUES[] PROGMEM = {CUE_END};
+
+
+static unsigned long readVarint(struct CueReader &reader) {
+  unsigned long value = 0;
+  uint8_t shift = 0;
+  uint8_t b;
+
+  do {
+    b = pgm_read_byte(reader.next++);
+    value |= (unsigned long)(b & 0x7F) << shift;
+    shift += 7;
+  } while(b & 0x80);
+
+  return value;
+}
+
+
+void cueBegin(struct CueReader &reader, const uint8_t cues[]) {
+  reader.next = cues;
+  reader.start = 0;
+}
+
+
+bool cueRead(struct CueReader &reader, struct AsyncTiming &cue) {
+  uint8_t head = pgm_read_byte(reader.next);
+
+  if((head & CUE_ACTION_MASK) == CUE_END) {
+    return false;
+  }
+
+  reader.next++;
+  reader.start += readVarint(reader);
+  reader.action = head & CUE_ACTION_MASK;
+
+  cue.callback = (CueAction)pgm_read_ptr(&CUE_ACTIONS[reader.action]);
+  cue.start = reader.start;
+  cue.repeat = head & CUE_REPEAT ? readVarint(reader) : 0;
+  cue.arg = head & CUE_ARG ? pgm_read_byte(reader.next++) : 0;
+  return true;
+}
+
+
+void cueSeek(struct CueReader &snapshot, struct CueReader &table, const uint8_t cues[], const uint8_t keys[], unsigned long position) {
+  unsigned long key = keys ? position / CUE_KEYFRAME : 0;
+  uint8_t count = keys ? pgm_read_byte(keys) : 0;
+
+  cueBegin(table, cues);
+  if(key > count) {
+    key = count;
+  }
+  if(!key) {
+    cueBegin(snapshot, NO_CUES);
+    return;
+  }
+
+  const uint8_t *offset = keys + 2 * key - 1;
+  cueBegin(snapshot, keys + (pgm_read_byte(offset) | pgm_read_byte(offset + 1) << 8));
+  table.next += readVarint(snapshot);
+  table.start = readVarint(snapshot);
+}
@@ -8,27 +8,19 @@
  * @copyright Copyright (c) 2022 John Scott.
  */
 #include <Arduino.h>
-#include <jled.h>
-#include <SoftwareSerial.h>
 #include "ahkfx.h"
 #include "aerialhk.h"
+#include "ahkleds.h"
+#include "ahklog.h"
+#include "ahkout.h"
+#include "ahksettings.h"
+#include "ahkstats.h"
 #include "pinout.h"
 
 
-//
-// Base LEDs...
-//
-auto blueLed = JLed(PIN_BLUE_FRONT).Off();
-auto redLed = JLed(PIN_RED_BACK).Off();
-
-
 //
 // Sounds...
 //
-#define VOL_MIN 0
-#define VOL_CENTRE 15
-#define VOL_MAX 30
-static int volume = VOL_CENTRE;
 
 // Sound commands.
 #define SND_PLAYMODE F("AT+PLAYMODE=3\r\n")
@@ -39,41 +31,210 @@ static int volume = VOL_CENTRE;
 #define SND_FLYMORE F("AT+PLAYFILE=/flymore.mp3\r\n")
 #define SND_LAND F("AT+PLAYFILE=/land.mp3\r\n")
 #define SND_SCENE_01 F("AT+PLAYFILE=/cut01.mp3\r\n")
-
-// Serial port to DFPlayer Pro.
+#define SND_PLAYPAUSE F("AT+PLAY=PP\r\n")
+#define SND_TIME F("AT+TIME=")
+
+// Sound command policy.
+#define SFX_QUEUE_SIZE 8 ///< Pending sound commands (power of 2).
+#define SFX_REPLY_SIZE 16 ///< Longest reply kept for error reporting.
+#define SFX_PLAY_TIMEOUT 1000 ///< Milliseconds to wait for a play command acknowledgement.
+#define SFX_PLAY_RETRIES 0 ///< Never resend a play or AT+PLAY=PP command, it may have acted.
+#define SFX_SET_TIMEOUT 250 ///< Milliseconds to wait for a setting acknowledgement.
+#define SFX_SET_RETRIES 2 ///< Resend settings that are not acknowledged.
+
+// Serial port to DFPlayer Pro. SoftwareSerial holds interrupts off for each
+// byte, about 2 ms for a play command, long enough to lose an IR frame and
+// stretch servo pulses. TimerSerial sends and receives a bit per interrupt
+// instead, at 19200 baud: set the DFPlayer once with AT+BAUDRATE=19200.
+// The Nano's only UART is the console.
+#define SOUND_SOFTSERIAL 1 ///< SoftwareSerial at 115200 baud.
+#define SOUND_TIMER0 2 ///< Interrupt driven TimerSerial at 19200 baud, receiving on INT1.
+
+#ifndef AHK_SOUND_TRANSPORT
+#define AHK_SOUND_TRANSPORT SOUND_SOFTSERIAL
+#endif
+
+#if AHK_SOUND_TRANSPORT == SOUND_TIMER0
+#include <TimerSerial.h>
+static_assert(PIN_SOUND_RX == TIMER_SERIAL_RX_PIN, "TimerSerial receives on INT1 only");
+#define SFX_BAUD 19200
+TimerSerial DFSerial(PIN_SOUND_TX);
+#else
+#include <SoftwareSerial.h>
+#define SFX_BAUD 115200
 SoftwareSerial DFSerial(PIN_SOUND_RX, PIN_SOUND_TX);  //RX  TX
+#endif
+
+struct SoundCommand {
+  const __FlashStringHelper *command; ///< AT command, or prefix if arg is used.
+  int arg; ///< Numeric argument followed by end of line, or -1 for none.
+  unsigned short timeout; ///< Milliseconds to wait for "OK".
+  unsigned char retries; ///< Resends remaining before giving up.
+  bool play; ///< Starts a track.
+};
+
+enum SoundState {
+  SFX_IDLE, ///< Nothing in flight, next command can be sent.
+  SFX_WAITING ///< Command at head of queue sent, waiting for "OK".
+};
+
+static struct SoundCommand sfxQueue[SFX_QUEUE_SIZE];
+static unsigned char sfxHead = 0;
+static unsigned char sfxCount = 0;
+static SoundState sfxState = SFX_IDLE;
+static unsigned long sfxSentAt = 0;
+static char sfxReply[SFX_REPLY_SIZE];
+static unsigned char sfxReplyLen = 0;
+static unsigned char sfxPlays = 0; ///< Play commands queued or waiting for "OK".
+static unsigned long sfxStartedAt = 0; ///< When the last play command finished.
+static bool sfxStarted = false; ///< Last play command acknowledged, rather than given up on.
+static bool sfxPaused = false; ///< Track paused, AT+PLAY=PP toggles it.
+
+static void setVolume(int level);
+
+
+//
+// Queue a command for the DFPlayer. Returns immediately, the command is sent
+// and acknowledged by loopAHKEffects().
+//
+static void queueSound(const __FlashStringHelper *command, int arg, unsigned short timeout, unsigned char retries, bool play = false) {
+  // Coalesce settings (e.g. volume) with the last one still waiting to be sent.
+  if(arg >= 0 && sfxCount && !(sfxCount == 1 && sfxState == SFX_WAITING)) {
+    struct SoundCommand &last = sfxQueue[(sfxHead + sfxCount - 1) & (SFX_QUEUE_SIZE - 1)];
+    if(last.command == command) {
+      last.arg = arg;
+      return;
+    }
+  }
+
+  if(sfxCount >= SFX_QUEUE_SIZE) {
+    logEvent(LOG_SFX_FULL);
+    return;
+  }
+
+  struct SoundCommand &cmd = sfxQueue[(sfxHead + sfxCount) & (SFX_QUEUE_SIZE - 1)];
+  cmd.command = command;
+  cmd.arg = arg;
+  cmd.timeout = timeout;
+  cmd.retries = retries;
+  cmd.play = play;
+  ++sfxCount;
+  sfxPlays += play;
+}
+
+static void queuePlay(const __FlashStringHelper *command) {
+  sfxPaused = false;
+  queueSound(command, -1, SFX_PLAY_TIMEOUT, SFX_PLAY_RETRIES, true);
+}
+
+static void sendSound() {
+  const struct SoundCommand &cmd = sfxQueue[sfxHead];
+
+  DFSerial.print(cmd.command);
+  if(cmd.arg >= 0) {
+    DFSerial.print(cmd.arg);
+    DFSerial.print(SND_VOLUME_END);
+  }
+
+  sfxReplyLen = 0;
+  sfxSentAt = millis();
+  sfxState = SFX_WAITING;
+}
 
-static void readAck() {
-  char str[81];
-  int i = 0;
-  char c = '\0';
-  long ms = millis();
-
-  while (millis() - ms < 1000) {
-    if(DFSerial.available()) {
-      c = DFSerial.read();
-      if(isprint(c)) {
-        str[i++] = c;
+static void nextSound(bool ok) {
+  if(sfxQueue[sfxHead].play) {
+    --sfxPlays;
+    sfxStartedAt = millis();
+    sfxStarted = ok;
+  }
+
+  sfxHead = (sfxHead + 1) & (SFX_QUEUE_SIZE - 1);
+  --sfxCount;
+  sfxState = SFX_IDLE;
+}
+
+static void retrySound(enum LogId error) {
+  struct SoundCommand &cmd = sfxQueue[sfxHead];
+
+  logEvent(error, logChars(sfxReply));
+
+  if(cmd.retries) {
+    --cmd.retries;
+    sfxState = SFX_IDLE;
+  } else {
+    nextSound(false);
+  }
+}
+
+
+//
+// Sound command state machine. Parses the reply a byte at a time so the main
+// loop never waits on the DFPlayer.
+//
+static void handleSound() {
+  while(DFSerial.available()) {
+    char c = DFSerial.read();
+
+    if(sfxState != SFX_WAITING) {
+      continue; // Discard anything unsolicited.
+    }
+
+    if(c == '\n') {
+      sfxReply[sfxReplyLen] = '\0';
+      if(strcmp(sfxReply, "OK")) {
+        retrySound(LOG_SFX_ERROR);
+      } else {
+        STATS_ACK_WAIT(millis() - sfxSentAt);
+        nextSound(true);
       }
+      break; // Leave any further bytes for the next command.
+    } else if(isprint(c) && sfxReplyLen < sizeof(sfxReply) - 1) {
+      sfxReply[sfxReplyLen++] = c;
     }
+  }
 
-    if(c == '\n' || i >= (int)(sizeof(str)-1)) break;
+  if(sfxState == SFX_WAITING && millis() - sfxSentAt >= sfxQueue[sfxHead].timeout) {
+    sfxReply[sfxReplyLen] = '\0';
+    retrySound(LOG_SFX_TIMEOUT);
   }
 
-  str[i]='\0';
-  if(strcmp(str, "OK")) {
-    Serial.print("SFX Receive Error: ");
-    Serial.println(str);
+  if(sfxState == SFX_IDLE && sfxCount) {
+    sendSound();
   }
 }
 
 
+bool isSoundStarting() {
+  return sfxPlays;
+}
+
+
+bool soundStartedAt(unsigned long &at) {
+  at = sfxStartedAt;
+  return sfxStarted;
+}
+
+
+bool soundNextDue(unsigned long &due) {
+  if(DFSerial.available() || (sfxState == SFX_IDLE && sfxCount)) {
+    due = millis();
+    return true;
+  }
+
+  if(sfxState == SFX_WAITING) {
+    due = sfxSentAt + sfxQueue[sfxHead].timeout;
+    return true;
+  }
+  return false;
+}
+
+
 void setupAHKEffects() {
-  DFSerial.begin(115200);
+  DFSerial.begin(SFX_BAUD);
 
-  DFSerial.print(SND_PLAYMODE); readAck();
+  queueSound(SND_PLAYMODE, -1, SFX_SET_TIMEOUT, SFX_SET_RETRIES);
   stopPlaying();
-  volumeCentre();
+  setVolume(settings.volume);
 
   pinMode(PIN_BLUE_FRONT, OUTPUT);
   blueLightsOff();
@@ -86,8 +247,9 @@ void setupAHKEffects() {
 
 
 void loopAHKEffects() {
-  blueLed.Update();
-  redLed.Update();
+  STATS_BEGIN();
+  handleSound();
+  STATS_END(STATS_LOOP_FX);
 }
 
 
@@ -96,29 +258,35 @@ void loopAHKEffects() {
 //
 
 void blueLightsOn() {
-  blueLed.Reset().On().Forever().Update();
+  outputsWrite(OUT_BLUE_LIGHTS, OUT_BLUE_LIGHTS);
+  ledEffect(OUT_BLUE_LIGHTS).On();
 }
 
 void blueLightsFlashOn() {
-  blueLed.Reset().Blink(50,50).Forever().Update();
+  outputsWrite(OUT_BLUE_LIGHTS, OUT_BLUE_LIGHTS);
+  ledEffect(OUT_BLUE_LIGHTS).Blink(50,50).Forever();
   plasmaGunOn();
 }
 
 void blueLightsOff() {
-  blueLed.Reset().Off().Forever().Update();
+  outputsWrite(OUT_BLUE_LIGHTS, 0);
+  ledEffect(OUT_BLUE_LIGHTS).Off();
   plasmaGunOff();
 }
 
 void redLightsOn() {
-  redLed.Reset().On().Forever().Update();
+  outputsWrite(OUT_RED_LIGHTS, OUT_RED_LIGHTS);
+  ledEffect(OUT_RED_LIGHTS).On();
 }
 
 void redLightsFlashOn() {
-  redLed.Reset().Blink(50,50).Forever().Update();
+  outputsWrite(OUT_RED_LIGHTS, OUT_RED_LIGHTS);
+  ledEffect(OUT_RED_LIGHTS).Blink(50,50).Forever();
 }
 
 void redLightsOff() {
-  redLed.Reset().Off().Forever().Update();
+  outputsWrite(OUT_RED_LIGHTS, 0);
+  ledEffect(OUT_RED_LIGHTS).Off();
 }
 
 
@@ -133,16 +301,15 @@ static void setVolume(int level) {
     level = VOL_MAX;
   }
 
-  DFSerial.print(SND_VOLUME);
-  DFSerial.print(level);
-  DFSerial.print(SND_VOLUME_END);
-  readAck();
-
-  volume = level;
+  queueSound(SND_VOLUME, level, SFX_SET_TIMEOUT, SFX_SET_RETRIES);
+  if(level != settings.volume) {
+    settings.volume = level;
+    settingsChanged();
+  }
 }
 
 void volumeUp() {
-  setVolume(volume + 1);
+  setVolume(settings.volume + 1);
 }
 
 void volumeCentre() {
@@ -150,25 +317,46 @@ void volumeCentre() {
 }
 
 void volumeDown() {
-  setVolume(volume - 1);
+  setVolume(settings.volume - 1);
 }
 
 void stopPlaying() {
-  DFSerial.print(SND_STOP); readAck();
+  queuePlay(SND_STOP);
 }
 
 void playTakeoff() {
-  DFSerial.print(SND_FLY); readAck();
+  queuePlay(SND_FLY);
 }
 
 void playLanding() {
-  DFSerial.print(SND_LAND); readAck();
+  queuePlay(SND_LAND);
 }
 
 void playFlyMore() {
-  DFSerial.print(SND_FLYMORE); readAck();
+  queuePlay(SND_FLYMORE);
 }
 
 void playScene01() {
-  DFSerial.print(SND_SCENE_01); readAck();
+  queuePlay(SND_SCENE_01);
+}
+
+void pauseSound() {
+  if(!sfxPaused) {
+    queueSound(SND_PLAYPAUSE, -1, SFX_PLAY_TIMEOUT, SFX_PLAY_RETRIES); // A toggle, a resend could undo it.
+    sfxPaused = true;
+  }
+}
+
+void resumeSound() {
+  if(sfxPaused) {
+    queuePlay(SND_PLAYPAUSE);
+  }
+}
+
+void seekSound(unsigned short seconds) {
+  if(sfxPaused) {
+    queueSound(SND_PLAYPAUSE, -1, SFX_PLAY_TIMEOUT, SFX_PLAY_RETRIES);
+    sfxPaused = false;
+  }
+  queueSound(SND_TIME, seconds, SFX_PLAY_TIMEOUT, SFX_PLAY_RETRIES, true);
 }
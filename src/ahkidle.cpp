@@ -0,0 +1,108 @@
+/**
+ * @file ahkidle.cpp
+ * @author John Scott
+ * @brief Aerial Hunter-Killer (AHK) Idle Sleep
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ *
+ * After each pass the next deadline is taken from the scheduler, sound queue,
+ * LED effects, servo curves, settings store and console log. Unless it is
+ * already due, or input is waiting, the CPU idles until the next interrupt
+ * and the loop looks again.
+ * Idle sleep stops only the CPU. millis() only moves on in Timer0's
+ * interrupt, which also wakes the CPU, so nothing falls due during a sleep
+ * without the loop seeing it at the same millisecond as before. IR edges,
+ * console and DFPlayer bytes and the servo timer wake it too.
+ *
+ * Power-down sleep would stop Timer0, and with it millis() and the servo
+ * pulses, and the IR decoder's edge interrupt cannot wake it. So the CPU
+ * idles and the unused ADC, SPI and TWI are switched off instead.
+ */
+#include <Arduino.h>
+#include <avr/sleep.h>
+#ifdef __AVR__
+#include <avr/power.h>
+#endif
+#include "ahkctrl.h"
+#include "ahkfx.h"
+#include "ahkidle.h"
+#include "ahkleds.h"
+#include "ahklog.h"
+#include "ahkmotion.h"
+#include "ahksettings.h"
+#include "ahkstream.h"
+
+#ifndef AHK_IDLE
+#define AHK_IDLE 1 ///< Sleep between events.
+#endif
+
+static struct IdleStats stats;
+static unsigned short idleMicros = 0; ///< Sleep not yet counted in stats.asleep.
+
+#if AHK_IDLE
+static bool (*const NEXT_DUE[])(unsigned long &due) = {
+  ctrlNextDue, soundNextDue, ledsNextDue, motionNextDue, settingsNextDue, logNextDue, streamNextDue
+};
+
+// Earliest deadline of every handler, false if nothing is waiting on time.
+static bool idleNextDue(unsigned long &due) {
+  bool timed = false;
+
+  for(bool (*nextDue)(unsigned long &) : NEXT_DUE) {
+    unsigned long at;
+    if(nextDue(at) && (!timed || (long)(at - due) < 0)) {
+      due = at;
+      timed = true;
+    }
+  }
+  return timed;
+}
+#endif
+
+
+void setupAHKIdle() {
+#ifdef __AVR__
+  ADCSRA = 0; // The random seed is read, the ADC is not needed again.
+  power_adc_disable();
+  power_spi_disable();
+  power_twi_disable();
+#endif
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  idleReset();
+}
+
+
+void loopAHKIdle() {
+#if AHK_IDLE
+  unsigned long due = 0;
+
+  if(idleNextDue(due) && (long)(due - millis()) <= 0) {
+    return;
+  }
+
+  unsigned long start = micros();
+  sleep_mode();
+
+  idleMicros += micros() - start;
+  while(idleMicros >= 1000) {
+    idleMicros -= 1000;
+    ++stats.asleep;
+  }
+  ++stats.sleeps;
+#endif
+}
+
+
+const struct IdleStats &idleStats() {
+  return stats;
+}
+
+
+void idleReset() {
+  stats.since = millis();
+  stats.asleep = 0;
+  stats.sleeps = 0;
+  idleMicros = 0;
+}
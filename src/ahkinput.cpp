@@ -0,0 +1,80 @@
+/**
+ * @file ahkinput.cpp
+ * @author John Scott
+ * @brief Aerial Hunter-Killer (AHK) Control Input Queue
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ *
+ * Head and tail are free-running byte counters, each written by one side
+ * only, so neither side needs to disable interrupts: single byte stores are
+ * atomic on AVR and the barrier keeps the slot written before it is published.
+ */
+#include <Arduino.h>
+#include "ahkinput.h"
+
+#define INPUT_MASK (INPUT_QUEUE_SIZE - 1)
+#define INPUT_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+static struct InputEvent inputQueue[INPUT_QUEUE_SIZE];
+static volatile unsigned char inputHead = 0; ///< Written by the producer.
+static volatile unsigned char inputTail = 0; ///< Written by the consumer.
+static struct InputStats stats;
+
+
+bool inputPush(char cmd) {
+  unsigned char head = inputHead;
+  unsigned char queued = head - inputTail;
+
+  if(queued >= INPUT_QUEUE_SIZE) {
+    stats.overflows++;
+    return false;
+  }
+
+  inputQueue[head & INPUT_MASK].cmd = cmd;
+  inputQueue[head & INPUT_MASK].received = micros();
+  INPUT_BARRIER();
+  inputHead = head + 1;
+
+  if(++queued > stats.highWater) {
+    stats.highWater = queued;
+  }
+  return true;
+}
+
+
+bool inputPop(struct InputEvent &event) {
+  unsigned char tail = inputTail;
+
+  if(tail == inputHead) {
+    return false;
+  }
+
+  INPUT_BARRIER();
+  event = inputQueue[tail & INPUT_MASK];
+  INPUT_BARRIER();
+  inputTail = tail + 1;
+  return true;
+}
+
+
+bool inputPending() {
+  return inputTail != inputHead;
+}
+
+
+void inputDone(const struct InputEvent &event) {
+  unsigned long latency = micros() - event.received;
+
+  stats.events++;
+  stats.totalLatency += latency;
+  if(latency > stats.maxLatency) {
+    stats.maxLatency = latency;
+  }
+}
+
+
+const struct InputStats &inputStats() {
+  return stats;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file ahkleds.cpp
+ * @author John Scott
+ * @brief Aerial Hunter-Killer (AHK) LED Effect Pool
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#include <Arduino.h>
+#include "ahkleds.h"
+#include "ahkout.h"
+#include "pinout.h"
+
+uint32_t ledsNow = 0;
+
+static const unsigned char LED_OUTPUTS[LED_COUNT] PROGMEM = {
+  OUT_LANDING_LIGHTS, OUT_PLASMA_GUN, OUT_BLUE_LIGHTS, OUT_RED_LIGHTS
+};
+
+static const unsigned char LED_PINS[LED_COUNT] PROGMEM = {
+  PIN_LANDING_LIGHTS, PIN_PLASMA_GUN, PIN_BLUE_FRONT, PIN_RED_BACK
+};
+
+static_assert(LED_COUNT <= 8, "Pool slots are bits of an unsigned char");
+
+static PoolLed leds[LED_COUNT] = {PoolLed(0), PoolLed(1), PoolLed(2), PoolLed(3)};
+static uint8_t ledLevels[LED_COUNT]; ///< Last brightness each effect set.
+static unsigned char ledsRunning = 0; ///< Slots with an effect to step.
+static unsigned char ledsChanged = 0; ///< Slots whose brightness changed this pass.
+static unsigned char ledsWritten = 0; ///< Slots driven at least once.
+
+
+void LedHal::analogWrite(uint8_t brightness) const {
+  unsigned char bit = 1 << slot_;
+  if(!(ledsWritten & bit) || ledLevels[slot_] != brightness) {
+    ledLevels[slot_] = brightness;
+    ledsWritten |= bit;
+    ledsChanged |= bit;
+  }
+}
+
+
+PoolLed &ledEffect(unsigned char output) {
+  unsigned char slot = 0;
+  while(slot < LED_COUNT - 1 && pgm_read_byte(&LED_OUTPUTS[slot]) != output) {
+    ++slot;
+  }
+
+  ledsRunning |= 1 << slot;
+  return leds[slot].Reset();
+}
+
+
+unsigned char ledsUpdate() {
+  if(!ledsRunning) {
+    return 0;
+  }
+
+  unsigned char ended = 0;
+  ledsNow = millis();
+  for(unsigned char slot = 0; slot < LED_COUNT; ++slot) {
+    unsigned char bit = 1 << slot;
+    if((ledsRunning & bit) && !leds[slot].Update()) {
+      ledsRunning &= ~bit;
+      ended |= pgm_read_byte(&LED_OUTPUTS[slot]);
+    }
+  }
+
+  // PWM pins fade, the rest are on at half brightness or more, as analogWrite().
+  unsigned char mask = 0;
+  unsigned char levels = 0;
+  for(unsigned char slot = 0; ledsChanged; ++slot) {
+    unsigned char bit = 1 << slot;
+    if(ledsChanged & bit) {
+      unsigned char pin = pgm_read_byte(&LED_PINS[slot]);
+      unsigned char output = pgm_read_byte(&LED_OUTPUTS[slot]);
+
+      if(digitalPinHasPWM(pin)) {
+        analogWrite(pin, ledLevels[slot]);
+      } else {
+        mask |= output;
+        levels |= ledLevels[slot] >= 128 ? output : 0;
+      }
+      ledsChanged &= ~bit;
+    }
+  }
+  if(mask) {
+    outputsDrive(mask, levels);
+  }
+  return ended;
+}
+
+
+bool ledsNextDue(unsigned long &due) {
+  if(!ledsRunning) {
+    return false;
+  }
+  due = millis() + 1;
+  return true;
+}
@@ -0,0 +1,183 @@
+/**
+ * @file ahklink.cpp
+ * @author John Scott
+ * @brief Aerial Hunter-Killer (AHK) Live Control Link
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#include <Arduino.h>
+#include "aerialhk.h"
+#include "ahkcue.h"
+#include "ahklink.h"
+#include "ahklog.h"
+#include "ahktimeline.h"
+
+enum LinkState : unsigned char {
+  LINK_IDLE, ///< Between frames.
+  LINK_SEQUENCE,
+  LINK_LENGTH,
+  LINK_COMMANDS,
+  LINK_CRC,
+  LINK_READY, ///< Checked, waiting for linkApply().
+  LINK_SKIP ///< Dropping the rest of a bad frame, linkSkip bytes or until quiet.
+};
+
+static enum LinkState linkState = LINK_IDLE;
+static uint8_t linkCommands[LINK_COMMANDS_MAX];
+static unsigned char linkSequence = 0;
+static unsigned char linkLength = 0;
+static unsigned char linkReceived = 0; ///< Command bytes received.
+static uint8_t linkCrc = 0; ///< CRC-8 so far.
+static unsigned long linkHeardAt = 0; ///< millis() of the last byte of the frame.
+static unsigned char linkLastSequence = 0; ///< Sequence of the last frame made.
+static unsigned short linkSkip = 0; ///< Bytes left to drop, 0 to drop until LINK_GAP ms pass quietly.
+
+
+// CRC-8, polynomial 0x07, a byte at a time.
+static uint8_t linkCrcByte(uint8_t crc, uint8_t b) {
+  crc ^= b;
+  for(unsigned char bit = 0; bit < 8; ++bit) {
+    crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+  }
+  return crc;
+}
+
+// Commands are known actions, with good arguments, each driving something
+// no other command of the frame drives.
+static bool linkValid() {
+  unsigned short driven = 0;
+
+  for(unsigned char at = 0; at < linkLength;) {
+    uint8_t head = linkCommands[at++];
+    unsigned char action = head & CUE_ACTION_MASK;
+    unsigned char arg = 0;
+
+    if((head & CUE_REPEAT) || action >= CUE_ACTION_COUNT) {
+      return false;
+    }
+    if(head & CUE_ARG) {
+      if(at >= linkLength) {
+        return false;
+      }
+      arg = linkCommands[at++];
+    }
+
+    struct CueInfo info;
+    memcpy_P(&info, &CUE_INFO[action], sizeof(info));
+    if(info.argMax ? arg < info.argMin || arg > info.argMax : arg != 0) {
+      return false;
+    }
+    if(driven & info.actuators) {
+      return false;
+    }
+    driven |= info.actuators;
+  }
+  return true;
+}
+
+// A whole frame has arrived, refuse, acknowledge or hold it for linkApply().
+static void linkFrame() {
+  linkState = LINK_IDLE;
+
+  if(linkCrc) {
+    logEvent(LOG_LINK_CRC); // Rate limited, the host sends it again.
+    linkState = LINK_SKIP; // The length may have been damaged too.
+    linkSkip = 0;
+  } else if(linkSequence && linkSequence == linkLastSequence) {
+    logRecord(LOG_LINK_ACK, 1, linkSequence, 0); // A repeat, its answer was lost.
+  } else if(!linkValid()) {
+    logRecord(LOG_LINK_NAK, 1, linkSequence, 0);
+  } else {
+    linkState = LINK_READY;
+  }
+}
+
+
+bool linkByte(int b) {
+  unsigned long now = millis();
+
+  // After a quiet gap a frame left part way is abandoned. Bytes that aren't
+  // a new frame are its tail, never keys.
+  if(linkState != LINK_IDLE && linkState != LINK_READY && now - linkHeardAt >= LINK_GAP) {
+    linkState = linkState == LINK_SKIP || b == LINK_MARK ? LINK_IDLE : LINK_SKIP;
+    linkSkip = 0;
+  }
+  linkHeardAt = now;
+
+  switch(linkState) {
+    case LINK_IDLE:
+      if(b != LINK_MARK) {
+        return false;
+      }
+      linkCrc = 0;
+      linkState = LINK_SEQUENCE;
+      break;
+
+    case LINK_SEQUENCE:
+      linkSequence = b;
+      linkCrc = linkCrcByte(linkCrc, b);
+      linkState = LINK_LENGTH;
+      break;
+
+    case LINK_LENGTH:
+      linkLength = b;
+      linkReceived = 0;
+      linkCrc = linkCrcByte(linkCrc, b);
+      if(linkLength > LINK_COMMANDS_MAX) {
+        linkState = LINK_SKIP;
+        linkSkip = linkLength + 1; // Commands and CRC.
+      } else {
+        linkState = linkLength ? LINK_COMMANDS : LINK_CRC;
+      }
+      break;
+
+    case LINK_COMMANDS:
+      linkCommands[linkReceived++] = b;
+      linkCrc = linkCrcByte(linkCrc, b);
+      if(linkReceived == linkLength) {
+        linkState = LINK_CRC;
+      }
+      break;
+
+    case LINK_CRC:
+      linkCrc ^= b; // 0 if it matches.
+      linkFrame();
+      break;
+
+    case LINK_SKIP:
+      if(linkSkip && !--linkSkip) {
+        linkState = LINK_IDLE;
+      }
+      break;
+
+    case LINK_READY:
+      return false; // linkPending() callers don't read on.
+  }
+  return true;
+}
+
+
+bool linkPending() {
+  return linkState == LINK_READY;
+}
+
+
+void linkApply() {
+  if(linkState != LINK_READY) {
+    return;
+  }
+
+  ahkBegin();
+  for(unsigned char at = 0; at < linkLength;) {
+    uint8_t head = linkCommands[at++];
+    unsigned char arg = (head & CUE_ARG) ? linkCommands[at++] : 0;
+    timelineFire((CueAction)pgm_read_ptr(&CUE_ACTIONS[head & CUE_ACTION_MASK]), arg);
+  }
+  ahkCommit();
+
+  linkLastSequence = linkSequence;
+  linkState = LINK_IDLE;
+  logRecord(LOG_LINK_ACK, 1, linkSequence, 0); // Protocol, whatever AHK_LOG_LEVEL.
+}
@@ -0,0 +1,284 @@
+/**
+ * @file ahklog.cpp
+ * @author John Scott
+ * @brief Aerial Hunter-Killer (AHK) Console Log
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#include <Arduino.h>
+#include "ahklog.h"
+#ifdef AHK_LOG_TEXT
+#include "ahkscene.h"
+#endif
+
+#define LOG_RING_SIZE 64 ///< Bytes of frames waiting to be sent (power of 2).
+#define LOG_RING_MASK (LOG_RING_SIZE - 1)
+#define LOG_FRAME_MAX (3 + 5 + LOG_ARGS_MAX * 5 + 3) ///< Header, time, arguments, repeats.
+#define LOG_TX_ROOM 63 ///< Most the serial port can take at once.
+#define LOG_RATE_SLOTS logRateSlot(LOG_COUNT)
+
+#define LOG_RATE_MS(ID, SEVERITY, RATE, FORMAT) RATE,
+static const unsigned short LOG_RATE_MS[LOG_COUNT] PROGMEM = {LOG_MESSAGES(LOG_RATE_MS)};
+#undef LOG_RATE_MS
+
+#define LOG_SLOT(ID, SEVERITY, RATE, FORMAT) logRateSlot(ID),
+static const unsigned char LOG_SLOTS[LOG_COUNT] PROGMEM = {LOG_MESSAGES(LOG_SLOT)};
+#undef LOG_SLOT
+
+struct LogLimit {
+  unsigned long at; ///< millis() the message was last recorded.
+  unsigned short suppressed; ///< Repeats since then.
+  bool recorded; ///< at is set.
+};
+
+static struct LogLimit logLimits[LOG_RATE_SLOTS > 0 ? LOG_RATE_SLOTS : 1];
+
+// Each entry is the frame's length then the frame.
+static uint8_t logRing[LOG_RING_SIZE];
+static unsigned char logHead = 0; ///< Next byte to record.
+static unsigned char logTail = 0; ///< Next entry to send.
+static unsigned char logUsed = 0;
+static unsigned short logDropped = 0; ///< Messages lost to a full ring, not yet reported.
+static unsigned long logLastAt = 0; ///< millis() of the last frame recorded.
+
+
+//
+// Record...
+//
+static unsigned char putVarint(uint8_t *frame, unsigned char at, unsigned long value) {
+  while(value >= 0x80) {
+    frame[at++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  frame[at++] = (uint8_t)value;
+  return at;
+}
+
+static bool logPut(unsigned char id, unsigned char count, long arg0, long arg1, unsigned short suppressed, unsigned long now) {
+  uint8_t frame[LOG_FRAME_MAX];
+  unsigned char len = 0;
+
+  frame[len++] = LOG_MARK;
+  frame[len++] = id;
+  frame[len++] = count | (suppressed ? LOG_SUPPRESSED : 0);
+  len = putVarint(frame, len, now - logLastAt);
+  if(count > 0) {
+    len = putVarint(frame, len, ((unsigned long)arg0 << 1) ^ (unsigned long)(arg0 >> (sizeof(long) * 8 - 1)));
+  }
+  if(count > 1) {
+    len = putVarint(frame, len, ((unsigned long)arg1 << 1) ^ (unsigned long)(arg1 >> (sizeof(long) * 8 - 1)));
+  }
+  if(suppressed) {
+    len = putVarint(frame, len, suppressed);
+  }
+
+  if(LOG_RING_SIZE - logUsed < len + 1) {
+    return false;
+  }
+
+  logRing[logHead] = len;
+  for(unsigned char i = 0; i < len; ++i) {
+    logRing[(logHead + 1 + i) & LOG_RING_MASK] = frame[i];
+  }
+  logHead = (logHead + len + 1) & LOG_RING_MASK;
+  logUsed += len + 1;
+  logLastAt = now;
+  return true;
+}
+
+void logRecord(unsigned char id, unsigned char count, long arg0, long arg1) {
+  unsigned short rate = pgm_read_word(&LOG_RATE_MS[id]);
+  unsigned long now = millis();
+  struct LogLimit *limit = 0;
+  unsigned short suppressed = 0;
+
+  if(rate) {
+    limit = &logLimits[pgm_read_byte(&LOG_SLOTS[id])];
+    if(limit->recorded && now - limit->at < rate) {
+      if(limit->suppressed < 0xFFFF) {
+        limit->suppressed++;
+      }
+      return;
+    }
+    suppressed = limit->suppressed;
+  }
+
+  if(logDropped && logPut(LOG_DROPPED, 1, logDropped, 0, 0, now)) {
+    logDropped = 0;
+  }
+  if(logDropped || !logPut(id, count, arg0, arg1, suppressed, now)) {
+    if(logDropped < 0xFFFF) {
+      logDropped++;
+    }
+    return;
+  }
+
+  if(limit) {
+    limit->at = now;
+    limit->suppressed = 0;
+    limit->recorded = true;
+  }
+}
+
+long logChars(const char *text) {
+  unsigned long packed = 0;
+  for(unsigned char i = 0; i < 4 && text[i]; ++i) {
+    packed |= (unsigned long)(uint8_t)text[i] << (8 * i);
+  }
+  return (long)packed;
+}
+
+
+//
+// Send...
+//
+#ifdef AHK_LOG_TEXT
+#define LOG_FORMAT(ID, SEVERITY, RATE, FORMAT) static const char ID##_FORMAT[] PROGMEM = FORMAT;
+LOG_MESSAGES(LOG_FORMAT)
+#undef LOG_FORMAT
+
+#define LOG_FORMAT_OF(ID, SEVERITY, RATE, FORMAT) ID##_FORMAT,
+static const char *const LOG_FORMATS[LOG_COUNT] PROGMEM = {LOG_MESSAGES(LOG_FORMAT_OF)};
+#undef LOG_FORMAT_OF
+
+static unsigned long getVarint(unsigned char &at) {
+  unsigned long value = 0;
+  unsigned char shift = 0;
+  uint8_t b;
+
+  do {
+    b = logRing[at];
+    at = (at + 1) & LOG_RING_MASK;
+    value |= (unsigned long)(b & 0x7F) << shift;
+    shift += 7;
+  } while(b & 0x80);
+  return value;
+}
+
+// PROGMEM name of scene number, or 0.
+static const char *sceneName(unsigned long number) {
+  return number < SCENE_COUNT ? (const char *)pgm_read_ptr(&SCENES[number].name) : 0;
+}
+
+// Bytes the names %S adds to a message take.
+static unsigned char namesRoom(const char *format, const long *args, unsigned char count) {
+  unsigned char room = 0;
+  unsigned char arg = 0;
+
+  for(char c; arg < count && (c = pgm_read_byte(format++));) {
+    if(c != '%') {
+      continue;
+    }
+    const char *name = pgm_read_byte(format++) == 'S' ? sceneName(args[arg]) : 0;
+    room += name ? strlen_P(name) + 3 : 0;
+    ++arg;
+  }
+  return room;
+}
+
+// Print the entry at logTail as text, false if the port hasn't room for it yet.
+static bool logSend() {
+  unsigned char at = (logTail + 2) & LOG_RING_MASK; // Skip the length and LOG_MARK.
+  unsigned char id = logRing[at];
+  unsigned char info = logRing[(at + 1) & LOG_RING_MASK];
+  unsigned char count = info & ~LOG_SUPPRESSED;
+  const char *format = (const char *)pgm_read_ptr(&LOG_FORMATS[id]);
+
+  at = (at + 2) & LOG_RING_MASK;
+  getVarint(at); // Time, for the host decoder.
+  long args[LOG_ARGS_MAX];
+  for(unsigned char i = 0; i < count; ++i) {
+    unsigned long zigzag = getVarint(at);
+    args[i] = (long)(zigzag >> 1) ^ -(long)(zigzag & 1);
+  }
+
+  unsigned char room = strlen_P(format) + 11 * count + ((info & LOG_SUPPRESSED) ? 14 : 2) + namesRoom(format, args, count);
+  if(Serial.availableForWrite() < (room < LOG_TX_ROOM ? room : LOG_TX_ROOM)) {
+    return false;
+  }
+
+  unsigned char arg = 0;
+  for(char c; (c = pgm_read_byte(format++));) {
+    if(c != '%' || arg >= count) {
+      Serial.print(c);
+      continue;
+    }
+
+    c = pgm_read_byte(format++);
+    if(c == 'd') {
+      Serial.print(args[arg++]);
+    } else if(c == 'u') {
+      Serial.print((unsigned long)args[arg++]);
+    } else if(c == 'x') {
+      Serial.print((unsigned long)args[arg++], HEX);
+    } else if(c == 'S') {
+      const char *name = sceneName(args[arg]);
+      Serial.print((unsigned long)args[arg++]);
+      if(name) {
+        Serial.print(F(" ("));
+        Serial.print((const __FlashStringHelper *)name);
+        Serial.print(')');
+      }
+    } else if(c == 'c') {
+      ++format; // Width, always 4.
+      for(unsigned long packed = args[arg++]; packed & 0xFF; packed >>= 8) {
+        Serial.print((char)(packed & 0xFF));
+      }
+    }
+  }
+  if(info & LOG_SUPPRESSED) {
+    Serial.print(F(" (+"));
+    Serial.print(getVarint(at));
+    Serial.print(F(" more)"));
+  }
+  Serial.println();
+  return true;
+}
+#else
+static bool logEscaped(uint8_t b) {
+  return b == LOG_MARK || b == LOG_ESC;
+}
+
+// Copy the frame at logTail to the port, escaping LOG_MARK and LOG_ESC after
+// the first byte, false if the port hasn't room for it yet.
+static bool logSend() {
+  unsigned char len = logRing[logTail];
+  unsigned char room = len;
+  for(unsigned char i = 2; i <= len; ++i) {
+    room += logEscaped(logRing[(logTail + i) & LOG_RING_MASK]);
+  }
+  if(Serial.availableForWrite() < room) {
+    return false;
+  }
+
+  Serial.write(LOG_MARK);
+  for(unsigned char i = 2; i <= len; ++i) {
+    uint8_t b = logRing[(logTail + i) & LOG_RING_MASK];
+    if(logEscaped(b)) {
+      Serial.write(LOG_ESC);
+      b ^= LOG_ESC_FLIP;
+    }
+    Serial.write(b);
+  }
+  return true;
+}
+#endif
+
+void loopAHKLog() {
+  while(logUsed && logSend()) {
+    unsigned char len = logRing[logTail] + 1;
+    logTail = (logTail + len) & LOG_RING_MASK;
+    logUsed -= len;
+  }
+}
+
+
+bool logNextDue(unsigned long &due) {
+  if(!logUsed) {
+    return false;
+  }
+  due = millis() + 1; // A byte leaves the port about every 87 us.
+  return true;
+}
@@ -0,0 +1,206 @@
+/**
+ * @file ahkmotion.cpp
+ * @author John Scott
+ * @brief Aerial Hunter-Killer (AHK) Motion Groups
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ *
+ * Each move's own speed gives its duration. The moves of a group arrive
+ * together, each taking the longest duration of the group, so tilt and turn
+ * cues triggered together finish together. A group begun apart inside
+ * another, such as the thruster pair, arrives together on its own instead,
+ * keeping its speed whatever the outer group holds. Each servo is started
+ * over its duration with startEaseToD() without its own interrupt, and
+ * ServoEasing's one timer interrupt is enabled once to update them all.
+ *
+ * Curves are written by motionUpdate() each pass, interpolating between the
+ * two PROGMEM samples either side of now. A move or another curve on the
+ * same servo replaces a playing curve.
+ */
+#include <Arduino.h>
+#include "ahkcurve.h"
+#include "ahklog.h"
+#include "ahkmotion.h"
+
+struct MotionMove {
+  ServoEasing *servo;
+  int degrees;
+  uint16_t speed;
+  unsigned char set; ///< Moves of a set arrive together.
+};
+
+struct MotionCurve {
+  ServoEasing *servo; ///< 0 when the slot is free.
+  const uint8_t *curve;
+  unsigned long start;
+  int degrees; ///< Last angle written.
+};
+
+static struct MotionMove motionMoves[MOTION_SIZE];
+static unsigned char motionCount = 0;
+static unsigned char motionDepth = 0;
+static unsigned char motionSet = 0; ///< Set moves are added to, 1 outside apart groups.
+static unsigned char motionApartDepth = 0; ///< motionDepth the open apart group began at, or 0.
+static unsigned char motionSets = 0; ///< Sets since the outermost group began.
+static struct MotionCurve motionCurves[MOTION_SIZE];
+
+
+static void curveStop(ServoEasing &servo) {
+  for(unsigned char i = 0; i < MOTION_SIZE; ++i) {
+    if(motionCurves[i].servo == &servo) {
+      motionCurves[i].servo = 0;
+    }
+  }
+}
+
+
+void motionBegin(bool apart) {
+  if(!motionDepth++) {
+    motionSet = motionSets = 1;
+  } else if(apart && !motionApartDepth) {
+    motionSet = ++motionSets;
+    motionApartDepth = motionDepth;
+  }
+}
+
+
+void motionMove(ServoEasing &servo, int degrees, uint16_t speed) {
+  if(!motionDepth) {
+    motionBegin();
+    motionMove(servo, degrees, speed);
+    motionCommit();
+    return;
+  }
+
+  unsigned char i = 0;
+  while(i < motionCount && motionMoves[i].servo != &servo) {
+    ++i;
+  }
+
+  if(i == MOTION_SIZE) {
+    logEvent(LOG_MOTION_FULL);
+    return;
+  }
+
+  if(i == motionCount) {
+    ++motionCount;
+  }
+  motionMoves[i] = MotionMove{&servo, degrees, speed, motionSet}; // Latest move for a servo wins.
+}
+
+
+static unsigned long moveDuration(const struct MotionMove &m) {
+  return m.speed ? (unsigned long)abs(m.degrees - m.servo->getCurrentAngle()) * 1000 / m.speed : 0;
+}
+
+void motionCommit() {
+  if(!motionDepth) {
+    return;
+  }
+  if(motionDepth == motionApartDepth) {
+    motionSet = 1;
+    motionApartDepth = 0;
+  }
+  if(--motionDepth) {
+    return;
+  }
+
+  unsigned long durations[MOTION_SIZE];
+  for(unsigned char i = 0; i < motionCount; ++i) {
+    durations[i] = moveDuration(motionMoves[i]);
+  }
+
+  // The moves of a set all take the longest of them.
+  for(unsigned char i = 0; i < motionCount; ++i) {
+    for(unsigned char j = 0; j < motionCount; ++j) {
+      if(motionMoves[j].set == motionMoves[i].set && durations[j] > durations[i]) {
+        durations[i] = durations[j];
+      }
+    }
+  }
+
+  for(unsigned char i = 0; i < motionCount; ++i) {
+    curveStop(*motionMoves[i].servo);
+    motionMoves[i].servo->startEaseToD(motionMoves[i].degrees, durations[i], false);
+  }
+
+  if(motionCount) {
+    motionCount = 0;
+    enableServoEasingInterrupt();
+  }
+}
+
+
+int motionCurve(ServoEasing &servo, const uint8_t curve[]) {
+  unsigned char i = 0;
+
+  // Drop a move for this servo still waiting in the group.
+  while(i < motionCount && motionMoves[i].servo != &servo) {
+    ++i;
+  }
+  if(i < motionCount) {
+    motionMoves[i] = motionMoves[--motionCount];
+  }
+
+  curveStop(servo);
+  servo.stop();
+
+  i = 0;
+  while(i < MOTION_SIZE && motionCurves[i].servo) {
+    ++i;
+  }
+  if(i < MOTION_SIZE) {
+    motionCurves[i] = MotionCurve{&servo, curve, millis(), -1};
+  }
+
+  unsigned short samples = pgm_read_byte(curve + 1) | pgm_read_byte(curve + 2) << 8;
+  return pgm_read_byte(curve + CURVE_HEADER + samples - 1);
+}
+
+
+void motionUpdate() {
+  unsigned long now = millis();
+
+  for(unsigned char i = 0; i < MOTION_SIZE; ++i) {
+    struct MotionCurve &c = motionCurves[i];
+    if(!c.servo) {
+      continue;
+    }
+
+    const uint8_t *samples = c.curve + CURVE_HEADER;
+    uint8_t step = pgm_read_byte(c.curve);
+    unsigned short count = pgm_read_byte(c.curve + 1) | pgm_read_byte(c.curve + 2) << 8;
+    unsigned long elapsed = now - c.start;
+    unsigned long at = elapsed / step;
+    int degrees;
+
+    if(at + 1 >= count) {
+      degrees = pgm_read_byte(samples + count - 1);
+      c.servo->write(degrees);
+      c.servo = 0;
+      continue;
+    }
+
+    int from = pgm_read_byte(samples + at);
+    int to = pgm_read_byte(samples + at + 1);
+    degrees = from + (to - from) * (int)(elapsed - at * step) / step;
+
+    if(degrees != c.degrees) {
+      c.servo->write(degrees);
+      c.degrees = degrees;
+    }
+  }
+}
+
+
+bool motionNextDue(unsigned long &due) {
+  for(unsigned char i = 0; i < MOTION_SIZE; ++i) {
+    if(motionCurves[i].servo) {
+      due = millis() + 1;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file ahkout.cpp
+ * @author John Scott
+ * @brief Aerial Hunter-Killer (AHK) Output Register
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ *
+ * On AVR the direct outputs are written straight to their port registers, all
+ * changes to one port in a single read-modify-write with interrupts held off
+ * (the servo interrupt writes PORTB too). Elsewhere digitalWrite() is used.
+ */
+#include <Arduino.h>
+#include "ahkout.h"
+#include "pinout.h"
+
+unsigned char outputState = 0;
+static unsigned char outputsHeld = 0; ///< Direct outputs changed since outputsBegin().
+static bool outputsHolding = false;
+
+static const unsigned char OUTPUT_PINS[OUT_COUNT] PROGMEM = {
+  PIN_TAIL_LIGHTS, PIN_SEARCH_LIGHTS, PIN_LANDING_LIGHTS,
+  PIN_PLASMA_GUN, PIN_BLUE_FRONT, PIN_RED_BACK
+};
+
+#ifdef __AVR__
+// ATmega328P (Nano): D0-D7 on PORTD, D8-D13 on PORTB, A0-A5 (D14-D19) on PORTC.
+#define PORT_D 0
+#define PORT_B 1
+#define PORT_C 2
+#define PIN_PORT(PIN) ((PIN) < 8 ? PORT_D : (PIN) < 14 ? PORT_B : PORT_C)
+#define PIN_MASK(PIN) (1 << ((PIN) < 8 ? (PIN) : (PIN) < 14 ? (PIN) - 8 : (PIN) - 14))
+
+static inline void portWrite(volatile uint8_t &port, uint8_t set, uint8_t clear) {
+  if(set | clear) {
+    port = (port & ~clear) | set;
+  }
+}
+#endif
+
+
+//
+// Drive the masked output pins to the levels in values.
+//
+static void outputsFlush(unsigned char mask, unsigned char values) {
+#ifdef __AVR__
+  uint8_t set[3] = {0, 0, 0};
+  uint8_t clear[3] = {0, 0, 0};
+
+  for(unsigned char i = 0; i < OUT_COUNT; ++i) {
+    unsigned char bit = 1 << i;
+    if(mask & bit) {
+      unsigned char pin = pgm_read_byte(&OUTPUT_PINS[i]);
+      if(values & bit) {
+        set[PIN_PORT(pin)] |= PIN_MASK(pin);
+      } else {
+        clear[PIN_PORT(pin)] |= PIN_MASK(pin);
+      }
+    }
+  }
+
+  uint8_t sreg = SREG;
+  cli();
+  portWrite(PORTD, set[PORT_D], clear[PORT_D]);
+  portWrite(PORTB, set[PORT_B], clear[PORT_B]);
+  portWrite(PORTC, set[PORT_C], clear[PORT_C]);
+  SREG = sreg;
+#else
+  for(unsigned char i = 0; i < OUT_COUNT; ++i) {
+    unsigned char bit = 1 << i;
+    if(mask & bit) {
+      digitalWrite(pgm_read_byte(&OUTPUT_PINS[i]), values & bit ? HIGH : LOW);
+    }
+  }
+#endif
+}
+
+
+void outputsWrite(unsigned char mask, unsigned char values) {
+  outputState = (outputState & ~mask) | (values & mask);
+
+  if(outputsHolding) {
+    outputsHeld |= mask & OUT_DIRECT;
+  } else if(mask & OUT_DIRECT) {
+    outputsFlush(mask & OUT_DIRECT, outputState);
+  }
+}
+
+
+void outputsBegin() {
+  outputsHolding = true;
+}
+
+
+void outputsCommit() {
+  outputsHolding = false;
+  if(outputsHeld) {
+    outputsFlush(outputsHeld, outputState);
+    outputsHeld = 0;
+  }
+}
+
+
+void outputsDrive(unsigned char mask, unsigned char levels) {
+  outputsFlush(mask, levels);
+}
@@ -0,0 +1,302 @@
+/**
+ * @file ahkscenes.cpp
+ * @author John Scott
+ * @brief Aerial Hunter-Killer (AHK) Scene Library
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ *
+ * To add a scene, write its AT_TIME list, PACK_CUES() it and register it in
+ * SCENES against a free number key. It costs only its packed cue bytes, and
+ * its keyframe index if it is PACK_KEYFRAMES()ed for fast seeking.
+ * A new action goes on the end of CUE_ACTIONS, with what it drives at the
+ * same place in CUE_INFO.
+ */
+#include <Arduino.h>
+#include "aerialhk.h"
+#include "ahkctrl.h"
+#include "ahkcue.h"
+#include "ahkfx.h"
+#include "ahkscene.h"
+#include "ahktimeline.h"
+
+// Actions taking their angle from the cue.
+static void tiltToCue() {
+  tiltTo(timelineArg());
+}
+
+static void turnToCue() {
+  turnTo(timelineArg());
+}
+
+static void thrustToCue() {
+  thrustTo(timelineArg());
+}
+
+#define AT_TILT(START, DEGREES) AT_WITH(START, tiltToCue, DEGREES)
+#define AT_TURN(START, DEGREES) AT_WITH(START, turnToCue, DEGREES)
+#define AT_THRUST(START, DEGREES) AT_WITH(START, thrustToCue, DEGREES)
+
+// Actions cue tables can call. Append new actions, packed tables index them.
+extern constexpr CueAction CUE_ACTIONS[] PROGMEM = {
+  tailLightsOn, tailLightsOff,
+  landingLightsOn, landingLightsOnOff, landingLightsOff,
+  searchLightsOn, searchLightsOff,
+  plasmaGunOn, plasmaGunOff,
+  tiltForward, tiltLevel, tiltBackward, tiltDive,
+  turnLeft, turnCentre, turnRight, turnRightRandom, turnScan,
+  startTurnRightRandom, stopTurning,
+  thrustMin, thrustBack, thrustHover, thrustForward, thrustMax, thrustLeft, thrustRight,
+  blueLightsOn, blueLightsFlashOn, blueLightsOff,
+  redLightsOn, redLightsFlashOn, redLightsOff,
+  playTakeoff, playFlyMore, playLanding, playScene01, stopPlaying,
+  tiltToCue, turnToCue, thrustToCue
+};
+
+// What each of CUE_ACTIONS drives, checked when cue tables are packed and
+// used to rebuild the state at a seek.
+extern constexpr struct CueInfo CUE_INFO[] PROGMEM = {
+  CUE_DRIVES(ACT_TAIL), CUE_DRIVES(ACT_TAIL),
+  CUE_DRIVES(ACT_LANDING), CUE_DRIVES(ACT_LANDING), CUE_DRIVES(ACT_LANDING),
+  CUE_DRIVES(ACT_SEARCH), CUE_DRIVES(ACT_SEARCH),
+  CUE_DRIVES(ACT_PLASMA), CUE_DRIVES(ACT_PLASMA),
+  CUE_DRIVES(ACT_TILT), CUE_DRIVES(ACT_TILT), CUE_DRIVES(ACT_TILT), CUE_DRIVES(ACT_TILT),
+  CUE_DRIVES(ACT_TURN), CUE_DRIVES(ACT_TURN), CUE_DRIVES(ACT_TURN), CUE_DRIVES(ACT_TURN), CUE_DRIVES(ACT_TURN),
+  CUE_DRIVES(ACT_TURN), CUE_DRIVES(ACT_TURN),
+  CUE_DRIVES(ACT_THRUST), CUE_DRIVES(ACT_THRUST), CUE_DRIVES(ACT_THRUST), CUE_DRIVES(ACT_THRUST),
+  CUE_DRIVES(ACT_THRUST), CUE_DRIVES(ACT_THRUST), CUE_DRIVES(ACT_THRUST),
+  CUE_DRIVES(ACT_BLUE), CUE_DRIVES(ACT_BLUE | ACT_PLASMA), CUE_DRIVES(ACT_BLUE | ACT_PLASMA),
+  CUE_DRIVES(ACT_RED), CUE_DRIVES(ACT_RED), CUE_DRIVES(ACT_RED),
+  CUE_DRIVES(ACT_SOUND), CUE_DRIVES(ACT_SOUND), CUE_DRIVES(ACT_SOUND), CUE_DRIVES(ACT_SOUND), CUE_DRIVES(ACT_SOUND),
+  CUE_DRIVES_TO(ACT_TILT, AHK_TILT_MIN, AHK_TILT_MAX),
+  CUE_DRIVES_TO(ACT_TURN, AHK_TURN_MIN, AHK_TURN_MAX),
+  CUE_DRIVES_TO(ACT_THRUST, AHK_THRUST_MIN, AHK_THRUST_MAX)
+};
+
+static_assert(sizeof(CUE_INFO) / sizeof(CUE_INFO[0]) == sizeof(CUE_ACTIONS) / sizeof(CUE_ACTIONS[0]), "CUE_INFO must match CUE_ACTIONS");
+
+extern const unsigned char CUE_ACTION_COUNT = sizeof(CUE_ACTIONS) / sizeof(CUE_ACTIONS[0]);
+
+static constexpr struct AsyncTiming POWER_ON_TIMINGS[] = {
+  AT_TIME(0, tailLightsOn),
+  AT_TIME(500, playTakeoff),
+  AT_TIME(550, landingLightsOnOff),
+  AT_TIME(5500, searchLightsOn),
+  AT_THEN_EVERY(15000, 30000, playFlyMore),
+  END_TIMINGS
+};
+
+PACK_CUES(POWER_ON, POWER_ON_TIMINGS);
+
+static constexpr struct AsyncTiming POWER_OFF_TIMINGS[] = {
+  AT_TIME(0, playLanding),
+  AT_TIME(250, blueLightsOff),
+  AT_TIME(250, redLightsOff),
+  AT_TIME(500, tiltLevel),
+  AT_TIME(1000, landingLightsOnOff),
+  AT_TIME(1500, turnCentre),
+  AT_TIME(2000, searchLightsOff),
+  AT_TIME(3500, thrustHover),
+  AT_TIME(10000, tailLightsOff),
+  END_TIMINGS
+};
+
+PACK_CUES(POWER_OFF, POWER_OFF_TIMINGS);
+
+static constexpr struct AsyncTiming CUT_SCENE_01_TIMINGS[] = {
+  AT_TIME(0, tailLightsOn),
+
+  AT_TIME(2000, landingLightsOnOff),
+  AT_TIME(5500, searchLightsOn),
+
+  AT_TIME(6000, thrustForward),
+  AT_TIME(6000, tiltForward),
+  AT_TIME(9232, blueLightsFlashOn),
+  AT_TIME(9300, redLightsFlashOn),
+  AT_TIME(9332, blueLightsOff),
+  AT_TIME(9375, redLightsOff),
+
+  AT_TIME(13000, thrustHover),
+  AT_TIME(13000, tiltBackward),
+
+  AT_TIME(14000, thrustRight),
+  AT_TIME(14000, turnRight),
+  AT_TIME(16000, thrustHover),
+  AT_TIME(16500, blueLightsFlashOn),
+  AT_TIME(16575, blueLightsOff),
+  AT_TIME(18000, redLightsFlashOn),
+  AT_TIME(18075, redLightsOff),
+  AT_TIME(18575, blueLightsFlashOn),
+  AT_TIME(18650, blueLightsOff),
+  AT_TIME(19250, redLightsFlashOn),
+  AT_TIME(19325, redLightsOff),
+  AT_TIME(19575, blueLightsFlashOn),
+  AT_TIME(19650, blueLightsOff),
+
+  AT_TIME(20000, thrustForward),
+  AT_TIME(20000, tiltForward),
+  AT_TIME(21700, blueLightsFlashOn),
+  AT_TIME(21800, blueLightsOff),
+  AT_TIME(22700, redLightsFlashOn),
+  AT_TIME(22775, redLightsOff),
+  AT_TIME(23060, redLightsFlashOn),
+  AT_TIME(23135, redLightsOff),
+
+  AT_TIME(24000, thrustLeft),
+  AT_TIME(24000, turnLeft),
+  AT_TIME(26000, thrustForward),
+
+  AT_TIME(28000, thrustHover),
+  AT_TIME(28000, tiltLevel),
+
+  AT_TIME(32000, thrustRight),
+  AT_TIME(32000, turnRight),
+  AT_TIME(34000, thrustHover),
+
+  AT_TIME(36000, thrustForward),
+  AT_TIME(36000, tiltForward),
+  AT_TIME(38600, redLightsFlashOn),
+  AT_TIME(38675, redLightsOff),
+
+  AT_TIME(40000, thrustHover),
+  AT_TIME(40000, tiltBackward),
+
+  AT_TIME(40000, startTurnRightRandom),
+  AT_TIME(40500, blueLightsFlashOn),
+  AT_TIME(41470, blueLightsOff),
+  AT_TIME(41900, redLightsFlashOn),
+  AT_TIME(42500, redLightsOff),
+  AT_TIME(42660, blueLightsFlashOn),
+  AT_TIME(43000, blueLightsOff),
+  AT_TIME(44400, blueLightsFlashOn),
+  AT_TIME(44500, redLightsFlashOn),
+  AT_TIME(45500, blueLightsOff),
+  AT_TIME(45700, redLightsOff),
+  AT_TIME(45700, blueLightsFlashOn),
+  AT_TIME(46700, blueLightsOff),
+  AT_TIME(46700, redLightsFlashOn),
+  AT_TIME(48300, redLightsOff),
+  AT_TIME(49000, blueLightsFlashOn),
+  AT_TIME(49000, redLightsOn),
+  AT_TIME(49750, redLightsOff),
+  AT_TIME(50000, blueLightsOff),
+  AT_TIME(50000, redLightsFlashOn),
+  AT_TIME(50700, blueLightsFlashOn),
+  AT_TIME(51300, blueLightsOff),
+  AT_TIME(51700, blueLightsFlashOn),
+  AT_TIME(52600, plasmaGunOff),
+  AT_TIME(52600, redLightsOn),
+  AT_TIME(52600, blueLightsOn),
+  AT_TIME(53000, stopTurning),
+  AT_TIME(55000, redLightsOff),
+  AT_TIME(55000, blueLightsOff),
+  AT_TIME(56000, thrustForward),
+  AT_TIME(56000, tiltForward),
+
+  AT_TIME(60000, thrustHover),
+  AT_TIME(60000, tiltBackward),
+  AT_TIME(63400, blueLightsFlashOn),
+  AT_TIME(63700, blueLightsOff),
+  AT_TIME(63700, redLightsOn),
+  AT_TIME(64500, redLightsOff),
+  AT_TIME(67200, redLightsOn),
+  AT_TIME(68500, blueLightsOn),
+  AT_TIME(69000, startTurnRightRandom),
+  AT_TIME(69500, redLightsOff),
+  AT_TIME(70000, blueLightsOff),
+  AT_TIME(70000, redLightsFlashOn),
+  AT_TIME(71100, redLightsOn),
+  AT_TIME(71100, blueLightsOn),
+  AT_TIME(72000, redLightsOff),
+  AT_TIME(72000, blueLightsOff),
+  AT_TIME(73000, redLightsFlashOn),
+  AT_TIME(75700, blueLightsFlashOn),
+  AT_TIME(77000, blueLightsOff),
+  AT_TIME(78000, blueLightsFlashOn),
+  AT_TIME(80000, redLightsOff),
+  AT_TIME(80200, blueLightsOff),
+  AT_TIME(80400, redLightsOn),
+  AT_TIME(80400, blueLightsOn),
+  AT_TIME(81800, blueLightsOff),
+  AT_TIME(83700, redLightsOff),
+  AT_TIME(83800, blueLightsFlashOn),
+  AT_TIME(85900, blueLightsOff),
+  AT_TIME(85900, redLightsOn),
+  AT_TIME(87000, stopTurning),
+  AT_TIME(87300, redLightsOff),
+
+  AT_TIME(87300, tiltForward),
+  AT_TIME(87400, turnLeft),
+  AT_TIME(87500, thrustMin),
+  AT_TIME(87500, searchLightsOff),
+  AT_TIME(88500, tailLightsOff),
+  AT_TIME(89000, redLightsOn),
+  AT_TIME(89000, blueLightsOn),
+  AT_TIME(91000, redLightsOff),
+  AT_TIME(91500, blueLightsOff),
+
+  AT_TIME(91500, thrustBack),
+  AT_TIME(91500, tiltLevel),
+  AT_TIME(91500, tailLightsOn),
+  AT_TIME(91500, landingLightsOnOff),
+  AT_TIME(93000, turnCentre),
+  AT_TIME(93000, thrustHover),
+  AT_TIME(93500, searchLightsOn),
+
+  AT_TIME(95000, thrustLeft),
+  AT_TIME(95500, turnLeft),
+  AT_TIME(97000, thrustHover),
+  AT_TIME(99000, thrustForward),
+  AT_TIME(99250, tiltForward),
+  AT_TIME(100000, blueLightsOn),
+  AT_TIME(100000, redLightsOn),
+
+  AT_TIME(102000, thrustRight),
+  AT_TIME(102000, turnRight),
+  AT_TIME(104500, thrustForward),
+
+  AT_TIME(106000, thrustLeft),
+  AT_TIME(106000, turnLeft),
+  AT_TIME(108500, thrustForward),
+
+  AT_TIME(110000, thrustRight),
+  AT_TIME(110000, turnRight),
+  AT_TIME(112500, thrustForward),
+
+  AT_TIME(114000, thrustLeft),
+  AT_TIME(114000, turnLeft),
+  AT_TIME(116500, thrustForward),
+
+  AT_TIME(118000, thrustRight),
+  AT_TIME(118000, turnRight),
+  AT_TIME(120500, thrustForward),
+
+  AT_TIME(121000, blueLightsOff),
+  AT_TIME(121000, redLightsOff),
+  AT_TIME(121500, tiltLevel),
+  AT_TIME(121500, landingLightsOnOff),
+  AT_TIME(122000, stopTurning),
+  AT_TIME(122500, turnCentre),
+  AT_TIME(123500, thrustHover),
+  AT_TIME(124000, searchLightsOff),
+  AT_TIME(130000, tailLightsOff),
+  END_TIMINGS
+};
+
+PACK_CUES(CUT_SCENE_01, CUT_SCENE_01_TIMINGS);
+PACK_KEYFRAMES(CUT_SCENE_01_KEYS, CUT_SCENE_01_TIMINGS);
+
+
+//
+// Scene registry...
+//
+static const char SCENE_01_NAME[] PROGMEM = "Program 01: Search and destroy";
+
+extern constexpr struct Scene POWER_ON_SCENE PROGMEM = {POWER_ON.bytes, 0, 0, 0};
+extern constexpr struct Scene POWER_OFF_SCENE PROGMEM = {POWER_OFF.bytes, 0, 0, 0};
+
+extern constexpr struct Scene SCENES[SCENE_COUNT] PROGMEM = {
+  {0, 0, 0, 0}, // 0 stops the running scene.
+  {CUT_SCENE_01.bytes, playScene01, SCENE_01_NAME, CUT_SCENE_01_KEYS.bytes},
+};
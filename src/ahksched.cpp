@@ -0,0 +1,193 @@
+/**
+ * @file ahksched.cpp
+ * @author John Scott
+ * @brief Aerial Hunter-Killer (AHK) Event Scheduler
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ *
+ * Events live in fixed slots and a binary heap of slot numbers orders them by
+ * due time, so the next event is always heap[0]. Each slot remembers its heap
+ * position, which makes cancelling O(log n) too. Handles carry the slot's
+ * generation, bumped whenever the slot is freed, so cancelling an event that
+ * has already fired cannot hit whatever reuses the slot. Due times are
+ * compared by signed difference, which stays correct across millis()
+ * wraparound for delays under 24 days.
+ */
+#include <Arduino.h>
+#include "ahklog.h"
+#include "ahksched.h"
+
+#define SCHED_FREE 0xFF ///< Heap position of an unused slot.
+
+struct SchedEvent {
+  void (*callback)();
+  unsigned long due; ///< millis() to call back.
+  unsigned long repeat; ///< Interval, or 0 for once.
+  unsigned char generation; ///< Bumped when the slot is freed.
+  unsigned char heapIndex; ///< Position in heap, or SCHED_FREE.
+};
+
+static struct SchedEvent events[SCHED_SIZE];
+static unsigned char heap[SCHED_SIZE]; ///< Slots ordered by due time.
+static unsigned char freeSlots[SCHED_SIZE]; ///< Stack of unused slots.
+static unsigned char freeCount = 0;
+static bool schedInit = false;
+static struct SchedStats stats;
+
+
+static inline bool before(unsigned long a, unsigned long b) {
+  return (long)(a - b) < 0;
+}
+
+static inline void place(unsigned char i, unsigned char slot) {
+  heap[i] = slot;
+  events[slot].heapIndex = i;
+}
+
+static void siftUp(unsigned char i) {
+  unsigned char slot = heap[i];
+
+  while(i) {
+    unsigned char parent = (i - 1) / 2;
+    if(!before(events[slot].due, events[heap[parent]].due)) {
+      break;
+    }
+    place(i, heap[parent]);
+    i = parent;
+  }
+  place(i, slot);
+}
+
+static void siftDown(unsigned char i) {
+  unsigned char slot = heap[i];
+
+  for(;;) {
+    unsigned char child = 2 * i + 1;
+    if(child >= stats.pending) {
+      break;
+    }
+    if(child + 1 < stats.pending && before(events[heap[child + 1]].due, events[heap[child]].due)) {
+      ++child;
+    }
+    if(!before(events[heap[child]].due, events[slot].due)) {
+      break;
+    }
+    place(i, heap[child]);
+    i = child;
+  }
+  place(i, slot);
+}
+
+static void release(unsigned char slot) {
+  unsigned char i = events[slot].heapIndex;
+  unsigned char last = heap[--stats.pending];
+
+  if(i != stats.pending) {
+    place(i, last);
+    siftDown(i);
+    siftUp(events[last].heapIndex);
+  }
+
+  events[slot].heapIndex = SCHED_FREE;
+  if(!++events[slot].generation) {
+    events[slot].generation = 1;
+  }
+  freeSlots[freeCount++] = slot;
+}
+
+static void init() {
+  for(unsigned char slot = 0; slot < SCHED_SIZE; ++slot) {
+    events[slot].heapIndex = SCHED_FREE;
+    events[slot].generation = 1;
+    freeSlots[slot] = SCHED_SIZE - 1 - slot;
+  }
+  freeCount = SCHED_SIZE;
+  schedInit = true;
+}
+
+
+SchedHandle schedule(void (*callback)(), unsigned long delay, unsigned long repeat) {
+  if(!schedInit) {
+    init();
+  }
+
+  if(!freeCount) {
+    stats.overflows++;
+    logEvent(LOG_SCHED_FULL);
+    return 0;
+  }
+
+  unsigned char slot = freeSlots[--freeCount];
+  struct SchedEvent &e = events[slot];
+  e.callback = callback;
+  e.due = millis() + delay;
+  e.repeat = repeat;
+
+  heap[stats.pending] = slot;
+  siftUp(stats.pending++);
+  if(stats.pending > stats.highWater) {
+    stats.highWater = stats.pending;
+  }
+
+  return ((SchedHandle)e.generation << 8) | slot;
+}
+
+
+bool schedCancel(SchedHandle handle) {
+  unsigned char slot = handle & 0xFF;
+
+  if(!handle || slot >= SCHED_SIZE || events[slot].heapIndex == SCHED_FREE
+      || events[slot].generation != handle >> 8) {
+    return false;
+  }
+
+  release(slot);
+  return true;
+}
+
+
+void schedCancelAll() {
+  while(stats.pending) {
+    release(heap[stats.pending - 1]);
+  }
+}
+
+
+bool schedNextDue(unsigned long &due) {
+  if(!stats.pending) {
+    return false;
+  }
+
+  due = events[heap[0]].due;
+  return true;
+}
+
+
+void schedRun() {
+  unsigned long now = millis();
+
+  while(stats.pending && !before(now, events[heap[0]].due)) {
+    unsigned char slot = heap[0];
+    struct SchedEvent &e = events[slot];
+    void (*callback)() = e.callback;
+
+    if(e.repeat) {
+      e.due += e.repeat;
+      if(before(e.due, now)) {
+        e.due = now + e.repeat; // Fell behind, don't call back in a burst.
+      }
+      siftDown(0);
+    } else {
+      release(slot);
+    }
+
+    callback(); // May schedule or cancel, the heap is consistent.
+  }
+}
+
+
+const struct SchedStats &schedStats() {
+  return stats;
+}
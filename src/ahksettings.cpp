@@ -0,0 +1,130 @@
+/**
+ * @file ahksettings.cpp
+ * @author John Scott
+ * @brief Aerial Hunter-Killer (AHK) Settings Store
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ *
+ * Settings are saved to a ring of SETTINGS_SLOTS records, each write to the
+ * slot after the last, so each cell is written 1/SETTINGS_SLOTS as often.
+ * A record is:
+ *
+ *   [sequence] [SETTINGS_VERSION] [struct Settings] [CRC-8]
+ *
+ * The sequence is one more than the record before it. At power on the whole
+ * ring is read in one block and the newest record is the valid one whose
+ * successor is not valid with the next sequence. A record torn by a power
+ * cut fails its CRC, which is written last, so the one before it is used.
+ *
+ * Changes are coalesced: nothing is written until the settings have been
+ * left alone for SETTINGS_DELAY ms. An EEPROM byte takes 3.3 ms to write, so
+ * the record is written a byte per pass when the EEPROM is ready, rather than
+ * stalling the loop. Unchanged bytes are not rewritten.
+ */
+#include <Arduino.h>
+#include <stddef.h>
+#include <avr/eeprom.h>
+#include "ahkfx.h"
+#include "ahksettings.h"
+
+#define SETTINGS_BASE 0 ///< EEPROM address of the ring.
+#define SETTINGS_SLOTS 16 ///< Records in the ring.
+#define SETTINGS_DELAY 5000 ///< Milliseconds without a change before saving.
+
+struct SettingsSlot {
+  uint8_t seq; ///< One more than the record before, wrapping.
+  uint8_t version; ///< SETTINGS_VERSION when written.
+  struct Settings settings;
+  uint8_t crc; ///< CRC-8 of everything before it.
+};
+
+static_assert(SETTINGS_BASE + SETTINGS_SLOTS * sizeof(struct SettingsSlot) <= E2END + 1, "Settings ring overruns the EEPROM");
+
+struct Settings settings = {VOL_CENTRE, 0, 0, 0};
+
+static unsigned char settingsSlot = SETTINGS_SLOTS - 1; ///< Slot of the newest record.
+static bool settingsDirty = false; ///< Changed since the record being or last written.
+static unsigned long settingsChangedAt = 0;
+static struct SettingsSlot settingsRecord; ///< Record being written.
+static unsigned char settingsWritten = sizeof(struct SettingsSlot); ///< Bytes of it written.
+
+
+// CRC-8, polynomial 0x07.
+static uint8_t settingsCrc(const uint8_t *data, size_t size) {
+  uint8_t crc = 0;
+
+  while(size--) {
+    crc ^= *data++;
+    for(unsigned char bit = 0; bit < 8; ++bit) {
+      crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+static bool settingsValid(const struct SettingsSlot &slot) {
+  return slot.version == SETTINGS_VERSION && slot.crc == settingsCrc((const uint8_t *)&slot, offsetof(struct SettingsSlot, crc));
+}
+
+
+void setupAHKSettings() {
+  struct SettingsSlot ring[SETTINGS_SLOTS];
+  eeprom_read_block(ring, (const void *)SETTINGS_BASE, sizeof(ring));
+
+  for(unsigned char i = 0; i < SETTINGS_SLOTS; ++i) {
+    const struct SettingsSlot &next = ring[(i + 1) % SETTINGS_SLOTS];
+
+    if(settingsValid(ring[i]) && !(settingsValid(next) && next.seq == (uint8_t)(ring[i].seq + 1))) {
+      settingsSlot = i;
+      settingsRecord = ring[i];
+      settings = ring[i].settings;
+      Serial.println(F("Settings loaded"));
+      return;
+    }
+  }
+  Serial.println(F("Settings defaults"));
+}
+
+
+void loopAHKSettings() {
+  if(settingsWritten < sizeof(struct SettingsSlot)) {
+    if(eeprom_is_ready()) {
+      uint8_t *to = (uint8_t *)(SETTINGS_BASE + settingsSlot * sizeof(struct SettingsSlot));
+      eeprom_update_byte(to + settingsWritten, ((const uint8_t *)&settingsRecord)[settingsWritten]);
+      ++settingsWritten;
+    }
+    return;
+  }
+
+  if(settingsDirty && millis() - settingsChangedAt >= SETTINGS_DELAY) {
+    settingsSlot = (settingsSlot + 1) % SETTINGS_SLOTS;
+    settingsRecord.seq++;
+    settingsRecord.version = SETTINGS_VERSION;
+    settingsRecord.settings = settings;
+    settingsRecord.crc = settingsCrc((const uint8_t *)&settingsRecord, offsetof(struct SettingsSlot, crc));
+    settingsWritten = 0;
+    settingsDirty = false;
+  }
+}
+
+
+void settingsChanged() {
+  settingsDirty = true;
+  settingsChangedAt = millis();
+}
+
+
+bool settingsNextDue(unsigned long &due) {
+  if(settingsWritten < sizeof(struct SettingsSlot)) {
+    due = millis() + 1;
+    return true;
+  }
+
+  if(settingsDirty) {
+    due = settingsChangedAt + SETTINGS_DELAY;
+    return true;
+  }
+  return false;
+}
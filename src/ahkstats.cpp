@@ -0,0 +1,152 @@
+/**
+ * @file ahkstats.cpp
+ * @author John Scott
+ * @brief Aerial Hunter-Killer (AHK) Instrumentation
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#include "ahkstats.h"
+
+#ifdef AHK_STATS
+
+#include "ahkidle.h"
+#include "ahkinput.h"
+#include "ahksched.h"
+#include "ahktimeline.h"
+
+struct HandlerStats {
+  unsigned long min; ///< Fastest run (us).
+  unsigned long max; ///< Slowest run (us).
+  unsigned long total; ///< Sum of runs, for the mean.
+  unsigned long count; ///< Runs.
+};
+
+static struct HandlerStats handlers[STATS_HANDLERS];
+static unsigned long loopPeriods[STATS_BUCKETS]; ///< Loops by period, bucket n holds < 2^n us.
+static unsigned long lastLoop = 0;
+static unsigned long ackWaitTotal = 0;
+static unsigned long ackWaitMax = 0;
+static unsigned long ackCount = 0;
+
+static const char HANDLER_NAMES[] PROGMEM = "loopAHK\0loopAHKCtrl\0loopAHKEffects";
+
+
+void statsHandler(unsigned char handler, unsigned long start) {
+  unsigned long us = micros() - start;
+  struct HandlerStats &h = handlers[handler];
+
+  if(!h.count || us < h.min) {
+    h.min = us;
+  }
+  if(us > h.max) {
+    h.max = us;
+  }
+  h.total += us;
+  h.count++;
+}
+
+
+void statsLoop() {
+  unsigned long now = micros();
+  unsigned long period = now - lastLoop;
+  unsigned char bucket = 0;
+
+  if(lastLoop) {
+    while(period && bucket < STATS_BUCKETS - 1) {
+      period >>= 1;
+      ++bucket;
+    }
+    loopPeriods[bucket]++;
+  }
+  lastLoop = now;
+}
+
+
+void statsAckWait(unsigned long ms) {
+  ackWaitTotal += ms;
+  if(ms > ackWaitMax) {
+    ackWaitMax = ms;
+  }
+  ackCount++;
+}
+
+
+void statsDump() {
+  const char *name = HANDLER_NAMES;
+
+  for(unsigned char i = 0; i < STATS_HANDLERS; ++i) {
+    const struct HandlerStats &h = handlers[i];
+
+    Serial.print((const __FlashStringHelper *)name);
+    Serial.print(F(" us min/mean/max: "));
+    Serial.print(h.min);
+    Serial.print('/');
+    Serial.print(h.count ? h.total / h.count : 0);
+    Serial.print('/');
+    Serial.println(h.max);
+    name += strlen_P(name) + 1;
+  }
+
+  Serial.print(F("Loop period log2(us) histogram:"));
+  for(unsigned char i = 0; i < STATS_BUCKETS; ++i) {
+    Serial.print(' ');
+    Serial.print(loopPeriods[i]);
+  }
+  Serial.println();
+
+  Serial.print(F("SFX ack wait ms total/max/count: "));
+  Serial.print(ackWaitTotal);
+  Serial.print('/');
+  Serial.print(ackWaitMax);
+  Serial.print('/');
+  Serial.println(ackCount);
+
+  const struct TimelineDrift &drift = timelineDrift();
+  Serial.print(F("Cue late ms last/mean/max (worst cue): "));
+  Serial.print(drift.late);
+  Serial.print('/');
+  Serial.print(drift.cues ? drift.totalLate / drift.cues : 0);
+  Serial.print('/');
+  Serial.print(drift.maxLate);
+  Serial.print(F(" ("));
+  Serial.print(drift.worstCue);
+  Serial.println(')');
+
+  const struct SchedStats &sched = schedStats();
+  Serial.print(F("Scheduler pending/high/overflows: "));
+  Serial.print(sched.pending);
+  Serial.print('/');
+  Serial.print(sched.highWater);
+  Serial.print('/');
+  Serial.println(sched.overflows);
+
+  const struct InputStats &input = inputStats();
+  Serial.print(F("Input key-to-action us mean/max, high/overflows: "));
+  Serial.print(input.events ? input.totalLatency / input.events : 0);
+  Serial.print('/');
+  Serial.print(input.maxLatency);
+  Serial.print(F(", "));
+  Serial.print(input.highWater);
+  Serial.print('/');
+  Serial.println(input.overflows);
+
+  // Battery life is roughly capacity / (awake current * awake + idle current * (1 - awake)).
+  const struct IdleStats &idle = idleStats();
+  unsigned long elapsed = millis() - idle.since;
+  Serial.print(F("Idle awake permille/asleep ms/sleeps: "));
+  Serial.print(elapsed < 1000 ? 1000 : (elapsed - idle.asleep) / (elapsed / 1000));
+  Serial.print('/');
+  Serial.print(idle.asleep);
+  Serial.print('/');
+  Serial.println(idle.sleeps);
+
+  memset(handlers, 0, sizeof(handlers));
+  memset(loopPeriods, 0, sizeof(loopPeriods));
+  ackWaitTotal = ackWaitMax = ackCount = 0;
+  lastLoop = 0;
+  idleReset();
+}
+
+#endif /* AHK_STATS */
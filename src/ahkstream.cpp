@@ -0,0 +1,249 @@
+/**
+ * @file ahkstream.cpp
+ * @author John Scott
+ * @brief Aerial Hunter-Killer (AHK) Streamed Scenes
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#include <Arduino.h>
+#include "ahkcue.h"
+#include "ahklog.h"
+#include "ahkstream.h"
+
+#define STREAM_MASK (STREAM_WINDOW - 1)
+#define STREAM_HEADER_SIZE 10 ///< Magic, version, action count and cue bytes.
+
+static_assert(STREAM_WINDOW <= 128 && !(STREAM_WINDOW & STREAM_MASK), "STREAM_WINDOW must be a power of 2 up to 128");
+
+static const char STREAM_MAGIC[] PROGMEM = "AHKS";
+
+enum StreamState : unsigned char {
+  STREAM_IDLE,
+  STREAM_HEADER, ///< Waiting for the header.
+  STREAM_CUES, ///< Reading cues.
+  STREAM_DISCARD ///< Abandoned, dropping bytes until the console is quiet.
+};
+
+static enum StreamState streamState = STREAM_IDLE;
+static uint8_t streamWindow[STREAM_WINDOW];
+static unsigned long streamReceived = 0; ///< Bytes of the file received.
+static unsigned long streamConsumed = 0; ///< Bytes of the file parsed.
+static unsigned long streamTotal = 0; ///< Bytes in the file, once the header is read.
+static unsigned long streamAllowed = 0; ///< Offset the host was last told it may send up to.
+static unsigned long streamAskedAt = 0;
+static unsigned long streamHeardAt = 0; ///< millis() of the last byte or new allowance.
+static unsigned long streamStart = 0; ///< Start time of the last cue read.
+
+
+static uint8_t peekByte(unsigned char at) {
+  return streamWindow[(streamConsumed + at) & STREAM_MASK];
+}
+
+// Read a varint at offset at of the unparsed bytes. False if it hasn't all arrived.
+static bool peekVarint(unsigned char &at, unsigned char available, unsigned long &value) {
+  value = 0;
+  for(unsigned char shift = 0; at < available; shift += 7) {
+    uint8_t b = peekByte(at++);
+    value |= (unsigned long)(b & 0x7F) << shift;
+    if(!(b & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static void streamFail(enum LogId why) {
+  logEvent(why, streamConsumed);
+  streamState = STREAM_DISCARD;
+  streamHeardAt = millis();
+}
+
+
+void streamBegin() {
+  streamState = STREAM_HEADER;
+  streamReceived = 0;
+  streamConsumed = 0;
+  streamTotal = 0;
+  streamAllowed = 0;
+  streamStart = 0;
+  streamHeardAt = millis();
+}
+
+
+void streamStop() {
+  if(streamState == STREAM_HEADER || streamState == STREAM_CUES) {
+    streamFail(LOG_STREAM_STOP);
+  }
+}
+
+
+bool isStreaming() {
+  return streamState != STREAM_IDLE;
+}
+
+
+bool streamReady() {
+  return streamState == STREAM_CUES && (streamReceived >= streamAllowed || streamReceived == streamTotal);
+}
+
+
+//
+// Header...
+//
+static void streamHeader() {
+  for(unsigned char i = 0; i < 4; ++i) {
+    if(peekByte(i) != pgm_read_byte(&STREAM_MAGIC[i])) {
+      streamFail(LOG_STREAM_ERROR);
+      return;
+    }
+  }
+  if(peekByte(4) != STREAM_VERSION || peekByte(5) != CUE_ACTION_COUNT) {
+    streamFail(LOG_STREAM_ERROR);
+    return;
+  }
+
+  streamTotal = STREAM_HEADER_SIZE;
+  for(unsigned char i = 0; i < 4; ++i) {
+    streamTotal += (unsigned long)peekByte(6 + i) << (8 * i);
+  }
+  streamConsumed = STREAM_HEADER_SIZE;
+  streamState = STREAM_CUES;
+}
+
+
+//
+// Fill the window from the console and tell the host how far it may send:
+// up to a window past the start of the half being read.
+//
+void streamPoll() {
+  unsigned long now = millis();
+
+  while(streamState != STREAM_IDLE && Serial.available()) {
+    if(streamState == STREAM_DISCARD) {
+      Serial.read();
+    } else if(streamReceived - streamConsumed < STREAM_WINDOW && (!streamTotal || streamReceived < streamTotal)) {
+      streamWindow[streamReceived++ & STREAM_MASK] = Serial.read();
+    } else {
+      break;
+    }
+    streamHeardAt = now;
+  }
+
+  if(streamState == STREAM_DISCARD) {
+    if(now - streamHeardAt >= STREAM_QUIET) {
+      streamState = STREAM_IDLE;
+    }
+    return;
+  }
+
+  if(streamState == STREAM_HEADER && streamReceived >= STREAM_HEADER_SIZE) {
+    streamHeader();
+  }
+  if(streamState == STREAM_IDLE || streamState == STREAM_DISCARD) {
+    return;
+  }
+
+  if(now - streamHeardAt >= STREAM_TIMEOUT) {
+    streamFail(LOG_STREAM_TIMEOUT);
+    return;
+  }
+
+  unsigned long allow = (streamConsumed & ~(unsigned long)(STREAM_HALF - 1)) + STREAM_WINDOW;
+  if(streamReceived >= allow || (streamTotal && streamReceived >= streamTotal)) {
+    streamHeardAt = now; // Waiting on the timeline, not the host.
+    return;
+  }
+
+  if(allow != streamAllowed) {
+    streamAllowed = allow;
+    streamHeardAt = now;
+  } else if(now - streamAskedAt < STREAM_ASK) {
+    return;
+  }
+
+  logRecord(LOG_STREAM_WANT, 1, allow, 0); // Flow control, whatever AHK_LOG_LEVEL.
+  streamAskedAt = now;
+}
+
+
+//
+// Cues, parsed in place once every byte of one has arrived...
+//
+enum StreamRead streamRead(struct AsyncTiming &cue) {
+  if(streamState != STREAM_CUES) {
+    return streamState == STREAM_HEADER ? STREAM_WAIT : STREAM_END;
+  }
+
+  unsigned char available = streamReceived - streamConsumed;
+  if(!available) {
+    // The file ended without CUE_END.
+    if(streamConsumed >= streamTotal) {
+      streamFail(LOG_STREAM_ERROR);
+      return STREAM_END;
+    }
+    return STREAM_WAIT;
+  }
+
+  uint8_t head = peekByte(0);
+  unsigned char action = head & CUE_ACTION_MASK;
+  if(action == CUE_END) {
+    ++streamConsumed;
+    logEvent(LOG_STREAM_DONE, streamConsumed);
+    streamState = streamReceived < streamTotal ? STREAM_DISCARD : STREAM_IDLE;
+    return STREAM_END;
+  }
+  if(action >= CUE_ACTION_COUNT) {
+    streamFail(LOG_STREAM_ERROR);
+    return STREAM_END;
+  }
+
+  unsigned char at = 1;
+  unsigned long delta;
+  unsigned long repeat = 0;
+  unsigned char arg = 0;
+  bool complete = peekVarint(at, available, delta) && (!(head & CUE_REPEAT) || peekVarint(at, available, repeat));
+  if(complete && (head & CUE_ARG)) {
+    complete = at < available;
+    arg = complete ? peekByte(at++) : 0;
+  }
+  if(!complete) {
+    // A cue is a few bytes, one that doesn't fit in the window or the rest
+    // of the file is corrupt.
+    if(available == STREAM_WINDOW || streamReceived >= streamTotal) {
+      streamFail(LOG_STREAM_ERROR);
+      return STREAM_END;
+    }
+    return STREAM_WAIT;
+  }
+
+  struct CueInfo info;
+  memcpy_P(&info, &CUE_INFO[action], sizeof(info));
+  if(info.argMax ? repeat || arg < info.argMin || arg > info.argMax : arg != 0) {
+    streamFail(LOG_STREAM_ERROR);
+    return STREAM_END;
+  }
+
+  streamConsumed += at;
+  streamStart += delta;
+  cue.callback = (CueAction)pgm_read_ptr(&CUE_ACTIONS[action]);
+  cue.start = streamStart;
+  cue.repeat = repeat;
+  cue.arg = arg;
+  return STREAM_CUE;
+}
+
+
+// Bytes arriving wake the loop, only asking again and giving up are timed.
+bool streamNextDue(unsigned long &due) {
+  if(streamState == STREAM_DISCARD) {
+    due = streamHeardAt + STREAM_QUIET;
+    return true;
+  }
+  if(streamState == STREAM_IDLE || streamReceived >= streamAllowed || (streamTotal && streamReceived >= streamTotal)) {
+    return false;
+  }
+  due = streamAskedAt + STREAM_ASK;
+  return true;
+}
@@ -0,0 +1,271 @@
+/**
+ * @file ahktimeline.cpp
+ * @author John Scott
+ * @brief Aerial Hunter-Killer (AHK) Cue Timeline
+ * @version 1.0
+ * @date 2022-05-08
+ *
+ * @copyright Copyright (c) 2022 John Scott.
+ */
+#include <Arduino.h>
+#include "aerialhk.h"
+#include "ahkcue.h"
+#include "ahklog.h"
+#include "ahksched.h"
+#include "ahkstream.h"
+#include "ahktimeline.h"
+
+static bool timelinePlaying = false;
+static bool timelinePaused = false;
+static unsigned long timelinePausedAt = 0; ///< Position when paused.
+static const uint8_t *timelineCues = 0; ///< Table playing, to seek in.
+static const uint8_t *timelineKeys = 0; ///< Its keyframe index, or 0.
+static bool timelineStreaming = false; ///< Cues come from the stream rather than a table.
+static struct CueReader timeline;
+static struct AsyncTiming timelineCue; ///< Next cue to fire.
+static unsigned short timelineStep = 0;
+static unsigned long timelineStart = 0;
+static SchedHandle timelineTimerId = 0;
+static struct TimelineDrift drift;
+static unsigned char timelineCueArg = 0;
+
+
+// Next cue of the table or stream, STREAM_WAIT if a streamed cue hasn't arrived.
+static enum StreamRead timelineRead(struct AsyncTiming &t) {
+  if(timelineStreaming) {
+    return streamRead(t);
+  }
+  return cueRead(timeline, t) ? STREAM_CUE : STREAM_END;
+}
+
+
+//
+// Fire every cue that is due, then sleep until the next one. Cues due
+// together are committed together.
+//
+static void timelineNext() {
+  unsigned long now = millis() - timelineStart;
+  struct AsyncTiming &t = timelineCue;
+
+  timelineTimerId = 0;
+  ahkBegin();
+
+  for(;;) {
+    enum StreamRead read = t.callback ? STREAM_CUE : timelineRead(t);
+    if(read == STREAM_WAIT) {
+      ahkCommit();
+      timelineTimerId = schedule(timelineNext, 1); // Late, look again once more has arrived.
+      return;
+    }
+    if(read == STREAM_END) {
+      timelinePlaying = false;
+      ahkCommit();
+      return;
+    }
+
+    if(t.start > now) {
+      break;
+    }
+
+    drift.cue = timelineStep++;
+    drift.late = now - t.start;
+    drift.totalLate += drift.late;
+    drift.cues++;
+    if(drift.late > drift.maxLate) {
+      drift.maxLate = drift.late;
+      drift.worstCue = drift.cue;
+    }
+
+    logEvent(LOG_CUE_LATE, drift.cue, drift.late);
+
+    void (*callback)() = t.callback;
+    t.callback = 0;
+    timelineCueArg = t.arg;
+    callback();
+
+    if(t.repeat) {
+      schedule(callback, t.repeat, t.repeat);
+    }
+  }
+
+  ahkCommit();
+  timelineTimerId = schedule(timelineNext, t.start - now);
+}
+
+
+void timelinePlay(const uint8_t cues[]) {
+  timelinePlay(cues, millis());
+}
+
+
+void timelinePlay(const uint8_t cues[], unsigned long start, const uint8_t keys[]) {
+  timelineStop();
+
+  cueBegin(timeline, cues);
+  timelineCues = cues;
+  timelineKeys = keys;
+  timelineStreaming = !cues;
+  timelineCue.callback = 0;
+  timelinePlaying = true;
+  timelineStep = 0;
+  timelineStart = start;
+  memset(&drift, 0, sizeof(drift));
+
+  timelineNext();
+}
+
+
+void timelineStream(unsigned long start) {
+  timelinePlay(0, start);
+}
+
+
+void timelineStop() {
+  if(timelineTimerId) {
+    schedCancel(timelineTimerId);
+    timelineTimerId = 0;
+  }
+  timelinePlaying = false;
+  timelinePaused = false;
+}
+
+
+void timelinePause() {
+  if(!timelinePlaying) {
+    return;
+  }
+
+  timelinePausedAt = millis() - timelineStart;
+  timelineStop();
+  timelinePaused = true;
+}
+
+
+bool isTimelinePaused() {
+  return timelinePaused;
+}
+
+
+unsigned long timelinePosition() {
+  if(timelinePaused) {
+    return timelinePausedAt;
+  }
+  return timelinePlaying ? millis() - timelineStart : 0;
+}
+
+
+//
+// Seek by firing, in order, each cue up to the position that is the latest
+// for at least one actuator it drives. Everything the actuators did before
+// that is overridden, so it is skipped. The cues are the keyframe snapshot
+// before the position then the table from the keyframe on (see ahkcue.h).
+// The first pass finds the latest cue for each actuator, the second fires
+// them. Cue numbers count from 1, 0 meaning no cue.
+//
+static unsigned short cueActuators(const struct CueReader &reader, unsigned short keep) {
+  return pgm_read_word(&CUE_INFO[reader.action].actuators) & ~keep;
+}
+
+// Next cue of the snapshot, then of the table. The reader it came from, or 0 at the end.
+static const struct CueReader *seekRead(struct CueReader &snapshot, struct CueReader &table, struct AsyncTiming &cue) {
+  if(cueRead(snapshot, cue)) {
+    return &snapshot;
+  }
+  return cueRead(table, cue) ? &table : 0;
+}
+
+void timelineSeek(unsigned long position, unsigned short keep) {
+  unsigned short latest[16] = {0};
+  unsigned short n = 0;
+  struct AsyncTiming &t = timelineCue;
+  struct CueReader snapshot;
+  const struct CueReader *from;
+
+  if(!timelineCues) {
+    return;
+  }
+  timelineStop();
+
+  cueSeek(snapshot, timeline, timelineCues, timelineKeys, position);
+  while((from = seekRead(snapshot, timeline, t)) && t.start <= position) {
+    unsigned short drives = cueActuators(*from, keep);
+    ++n;
+    for(unsigned char bit = 0; drives; ++bit, drives >>= 1) {
+      if(drives & 1) {
+        latest[bit] = n;
+      }
+    }
+  }
+
+  n = 0;
+  ahkBegin();
+  cueSeek(snapshot, timeline, timelineCues, timelineKeys, position);
+  while((from = seekRead(snapshot, timeline, t)) && t.start <= position) {
+    unsigned short drives = cueActuators(*from, keep);
+    ++n;
+    for(unsigned char bit = 0; drives; ++bit, drives >>= 1) {
+      if((drives & 1) && latest[bit] == n) {
+        timelineCueArg = t.arg;
+        t.callback();
+        break;
+      }
+    }
+    t.callback = 0;
+  }
+  ahkCommit();
+
+  // The table reader has gone one past the position, t holds that cue if there is one.
+  if(!from) {
+    t.callback = 0;
+  }
+  timelineStep = n;
+  timelinePausedAt = position;
+  timelinePaused = true;
+}
+
+
+void timelineResume(unsigned long start) {
+  if(!timelinePaused) {
+    return;
+  }
+
+  unsigned long position = timelinePausedAt + (millis() - start);
+  struct CueReader snapshot;
+  struct CueReader table;
+  struct AsyncTiming cue;
+
+  // Repeats started before the position, due next at their next multiple.
+  cueSeek(snapshot, table, timelineCues, timelineKeys, timelinePausedAt);
+  while(seekRead(snapshot, table, cue) && cue.start <= timelinePausedAt) {
+    if(cue.repeat) {
+      schedule(cue.callback, (cue.repeat - (position - cue.start) % cue.repeat) % cue.repeat, cue.repeat);
+    }
+  }
+
+  timelinePaused = false;
+  timelinePlaying = true;
+  timelineStart = start - timelinePausedAt;
+  memset(&drift, 0, sizeof(drift));
+  timelineNext();
+}
+
+
+bool isTimelinePlaying() {
+  return timelinePlaying;
+}
+
+
+const struct TimelineDrift &timelineDrift() {
+  return drift;
+}
+
+
+unsigned char timelineArg() {
+  return timelineCueArg;
+}
+
+
+void timelineFire(void (*action)(), unsigned char arg) {
+  timelineCueArg = arg;
+  action();
+}
@@ -11,6 +11,10 @@
 #include "aerialhk.h"
 #include "ahkctrl.h"
 #include "ahkfx.h"
+#include "ahkidle.h"
+#include "ahklog.h"
+#include "ahksettings.h"
+#include "ahkstats.h"
 #include "pinout.h"
 #include "ver_info.h"
 
@@ -25,15 +29,21 @@ void setup() {
 
   randomSeed(analogRead(PIN_RANDOMISE));  // Randomise
 
+  setupAHKSettings();
   setupAHK();
   setupAHKCtrl();
   setupAHKEffects();
+  setupAHKIdle();
 
   Serial.println(F("\nSystem Restart Complete\n"));
 }
 
 void loop() {
+  STATS_LOOP();
+  loopAHKCtrl(); // Commands and cues first, so the outputs below change in the same pass.
   loopAHK();
-  loopAHKCtrl();
   loopAHKEffects();
+  loopAHKSettings();
+  loopAHKLog(); // After everything that logs, so this pass's messages go out now.
+  loopAHKIdle(); // Sleep until something is next due.
 }
@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""Drive the Aerial HK live over the console in framed batches of actions.
+
+Each frame is a batch of actions the unit makes in one loop pass (see
+include/ahklink.h). Actions are the names in CUE_ACTIONS, with =value for
+those taking an argument, or the AT_ helpers' names in lower case:
+
+    tilt=150 turn=60 blueLightsFlashOn thrustRight
+
+Each argument is sent as a frame, then each line of stdin if the argument
+is -, so a host program can pipe its choreography in. A frame is sent again
+if the unit doesn't answer within --retry seconds. The unit's log is
+printed as it arrives (see tools/ahklog.py). --hex prints the frames instead
+of sending them, for the native program's -x option.
+
+    tools/ahklink.py --port /dev/ttyUSB0 'tilt=150 turn=60 blueLightsFlashOn thrustRight'
+    my_show.py | tools/ahklink.py --port /dev/ttyUSB0 -
+    .pio/build/native/program -x 1000:$(tools/ahklink.py --hex 'tilt=150 turn=60') | tools/ahklog.py
+"""
+import argparse
+import re
+import sys
+import threading
+
+import ahklog
+import ahkscene
+
+LINK_MARK = 0x02
+LINK_COMMANDS_MAX = 32
+CUE_ARG = 0x40
+ANSWER = re.compile(r'Link (ack|nak) (\d+)')
+
+
+class LinkError(Exception):
+    pass
+
+
+def crc8(data):
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07 if crc & 0x80 else crc << 1) & 0xFF
+    return crc
+
+
+def load_commands():
+    """Index, argument range and actuators of each action, by name."""
+    defines = ahkscene.load_defines(ahkscene.INCLUDE)
+    actions, info, helpers = ahkscene.load_actions(ahkscene.SCENES, defines)
+    commands = {name: (i, info[i]) for i, name in enumerate(actions)}
+    for macro, action in helpers.items():
+        commands[macro[len('AT_'):].lower()] = commands[action]
+    return commands, defines
+
+
+def frame(sequence, text, commands, defines):
+    """Frame of the batch of actions in text."""
+    data = bytearray()
+    driven = 0
+    for word in text.split():
+        name, _, value = word.partition('=')
+        if name not in commands:
+            raise LinkError('unknown action %s' % name)
+        index, (actuators, arg_min, arg_max) = commands[name]
+        if driven & actuators:
+            raise LinkError('%s drives what another action of the frame drives' % name)
+        driven |= actuators
+
+        if not arg_max:
+            if value:
+                raise LinkError('%s takes no argument' % name)
+            data.append(index)
+            continue
+        arg = ahkscene.evaluate(value, defines) if value else None
+        if arg is None or not arg_min <= arg <= arg_max:
+            raise LinkError('%s takes %d to %d' % (name, arg_min, arg_max))
+        data += bytes([index | CUE_ARG, arg])
+
+    if len(data) > LINK_COMMANDS_MAX:
+        raise LinkError('more than %d bytes of actions' % LINK_COMMANDS_MAX)
+    body = bytes([sequence, len(data)]) + data
+    return bytes([LINK_MARK]) + body + bytes([crc8(body)])
+
+
+def batches(args):
+    for batch in args.frames:
+        if batch == '-':
+            for line in sys.stdin:
+                if line.strip():
+                    yield line
+        else:
+            yield batch
+
+
+class Answers:
+    """Log output that notes the unit's answers to frames."""
+
+    def __init__(self):
+        self.answered = threading.Condition()
+        self.answers = {}
+
+    def write(self, text):
+        sys.stdout.write(text)
+        m = ANSWER.search(text)
+        if m:
+            with self.answered:
+                self.answers[int(m.group(2))] = m.group(1)
+                self.answered.notify()
+
+    def flush(self):
+        sys.stdout.flush()
+
+    def wait(self, sequence, timeout):
+        with self.answered:
+            self.answered.wait_for(lambda: sequence in self.answers, timeout)
+            return self.answers.pop(sequence, None)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('frames', nargs='+', help="actions of a frame, or - for a frame a line from stdin")
+    parser.add_argument('--port', help='serial port of the unit')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--retry', type=float, default=0.2, help='seconds to wait for an answer')
+    parser.add_argument('--tries', type=int, default=5)
+    parser.add_argument('--hex', action='store_true', help='print the frames in hex instead')
+    args = parser.parse_args()
+
+    commands, defines = load_commands()
+    if args.hex:
+        try:
+            print(''.join(frame((i - 1) % 255 + 1 if i else 0, b, commands, defines).hex() for i, b in enumerate(batches(args))))
+        except LinkError as e:
+            sys.exit('%s: %s' % (parser.prog, e))
+        return
+    if not args.port:
+        parser.error('--port or --hex is needed')
+
+    import serial
+    port = serial.Serial(args.port, args.baud)
+    answers = Answers()
+    reader = threading.Thread(target=ahklog.decode, args=(ahklog.read_bytes(port), ahklog.load_messages(ahklog.HEADER), answers), daemon=True)
+    reader.start()
+
+    sequence = 0  # Never taken for a repeat, so the unit starts afresh.
+    try:
+        for batch in batches(args):
+            data = frame(sequence, batch, commands, defines)
+            for _ in range(args.tries):
+                port.write(data)
+                answer = answers.wait(sequence, args.retry)
+                if answer:
+                    break
+            else:
+                raise LinkError('no answer to frame %d' % sequence)
+            if answer == 'nak':
+                raise LinkError('frame %d refused: %s' % (sequence, batch.strip()))
+            sequence = sequence % 255 + 1
+    except LinkError as e:
+        sys.exit('%s: %s' % (parser.prog, e))
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+"""Decode the Aerial HK binary console log back into text.
+
+Reads a captured console (a file or stdin) or a live serial port and prints
+the console's text as it is, with each binary log frame (see include/ahklog.h)
+as a line of text:
+
+    [   12.345] WARN  IR Code Error: 99 (+2 more)
+
+Message formats are read from include/ahklog.h, and scene names from
+src/ahkscenes.cpp, so the decoder matches the firmware built from the same
+tree. Times are seconds since the first frame
+seen, or since power on if the capture starts at reset.
+
+    tools/ahklog.py capture.bin
+    tools/ahklog.py --port /dev/ttyUSB0          (needs pyserial)
+    .pio/build/native/program -d 10 -k 500:'*' | tools/ahklog.py
+"""
+import argparse
+import os
+import re
+import sys
+
+LOG_MARK = 0x1E
+LOG_ESC = 0x1D
+LOG_ESC_FLIP = 0x20
+LOG_SUPPRESSED = 0x80
+HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'include', 'ahklog.h')
+SCENES = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'src', 'ahkscenes.cpp')
+MESSAGE = re.compile(r'M\((\w+),\s*LOG_(\w+),\s*(\d+),\s*"((?:[^"\\]|\\.)*)"\)')
+NAME = re.compile(r'\b(\w+)\[\]\s*PROGMEM\s*=\s*"((?:[^"\\]|\\.)*)"')
+
+
+def load_messages(path):
+    """(id name, severity, format) for each message, in id order."""
+    with open(path) as header:
+        return [(m.group(1), m.group(2), m.group(4)) for m in MESSAGE.finditer(header.read())]
+
+
+def load_scenes(path):
+    """Name of each numbered scene in SCENES, None for one without."""
+    try:
+        with open(path) as source:
+            text = re.sub(r'//[^\n]*|/\*.*?\*/', '', source.read(), flags=re.S)
+    except OSError:
+        return []
+    names = dict(NAME.findall(text))
+    table = re.search(r'\bSCENES\s*\[[^\]]*\]\s*PROGMEM\s*=\s*\{(.*?)\n\};', text, re.S)
+    if not table:
+        return []
+    return [names.get(entry.split(',')[2].strip()) if entry.count(',') >= 2 else None
+            for entry in re.findall(r'\{([^{}]*)\}', table.group(1))]
+
+
+class Resync(Exception):
+    """A LOG_MARK inside a frame, the frame was cut short."""
+
+
+def frame_bytes(data):
+    """Bytes of the frame after LOG_MARK, unescaped."""
+    for b in data:
+        if b == LOG_MARK:
+            raise Resync
+        if b == LOG_ESC:
+            b = next(data, None)
+            if b is None:
+                return
+            if b == LOG_MARK:
+                raise Resync
+            b ^= LOG_ESC_FLIP
+        yield b
+
+
+def read_varint(data):
+    value = shift = 0
+    while True:
+        b = next(data)
+        value |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            return value
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def format_message(fmt, args, scenes=()):
+    out = []
+    args = list(args)
+    i = 0
+    while i < len(fmt):
+        c = fmt[i]
+        if c != '%' or not args or i + 1 >= len(fmt):
+            out.append(c)
+            i += 1
+            continue
+        conv = fmt[i + 1]
+        arg = args.pop(0)
+        i += 2
+        if conv == 'd':
+            out.append(str(arg))
+        elif conv == 'u':
+            out.append(str(arg & 0xFFFFFFFF))
+        elif conv == 'x':
+            out.append('%X' % (arg & 0xFFFFFFFF))
+        elif conv == 'S':
+            out.append(str(arg))
+            if 0 <= arg < len(scenes) and scenes[arg]:
+                out.append(' (%s)' % scenes[arg])
+        elif conv == 'c':
+            i += 1  # Width, always 4.
+            packed = arg & 0xFFFFFFFF
+            while packed & 0xFF:
+                out.append(chr(packed & 0xFF))
+                packed >>= 8
+    return ''.join(out)
+
+
+def read_frame(data, out):
+    """(id, ms since the last frame, arguments, repeats suppressed) of the
+    frame after LOG_MARK, or of the next one if it is cut short."""
+    while True:
+        frame = frame_bytes(data)
+        try:
+            ident = next(frame)
+            info = next(frame)
+            ms = read_varint(frame)
+            args = [unzigzag(read_varint(frame)) for _ in range(info & ~LOG_SUPPRESSED & 0xFF)]
+            suppressed = read_varint(frame) if info & LOG_SUPPRESSED else 0
+            return ident, ms, args, suppressed
+        except Resync:
+            out.write('[broken frame]\n')
+
+
+def decode(data, messages, out, scenes=None):
+    """Copy text from the byte iterator data to out, decoding frames."""
+    scenes = load_scenes(SCENES) if scenes is None else scenes
+    now = 0
+    line = bytearray()
+    data = iter(data)
+
+    for b in data:
+        if b != LOG_MARK:
+            line.append(b)
+            if b == 0x0A:
+                out.write(line.decode('latin-1'))
+                line.clear()
+            continue
+
+        if line:
+            out.write(line.decode('latin-1') + '\n')
+            line.clear()
+        try:
+            ident, ms, args, suppressed = read_frame(data, out)
+        except StopIteration:
+            out.write('[truncated frame]\n')
+            break
+        now += ms
+
+        if ident < len(messages):
+            name, severity, fmt = messages[ident]
+            text = format_message(fmt, args, scenes)
+        else:
+            severity, text = '?', 'Unknown message %d %s' % (ident, args)
+        if suppressed:
+            text += ' (+%d more)' % suppressed
+        out.write('[%10.3f] %-5s %s\n' % (now / 1000.0, severity, text))
+        out.flush()
+
+    if line:
+        out.write(line.decode('latin-1'))
+
+
+def read_bytes(stream):
+    while True:
+        chunk = stream.read(1) if hasattr(stream, 'in_waiting') else stream.read1(4096)
+        if not chunk:
+            return
+        yield from chunk
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('capture', nargs='?', help='captured console, stdin if omitted')
+    parser.add_argument('--port', help='serial port to read live')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--header', default=HEADER, help='ahklog.h listing the messages')
+    parser.add_argument('--scenes', default=SCENES, help='ahkscenes.cpp naming the scenes')
+    args = parser.parse_args()
+
+    messages = load_messages(args.header)
+    if args.port:
+        import serial
+        stream = serial.Serial(args.port, args.baud)
+    elif args.capture:
+        stream = open(args.capture, 'rb')
+    else:
+        stream = sys.stdin.buffer
+
+    try:
+        decode(read_bytes(stream), messages, sys.stdout, load_scenes(args.scenes))
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,264 @@
+#!/usr/bin/env python3
+"""Convert an Aerial HK scene to a scene file and stream it to the unit.
+
+A scene is written as in src/ahkscenes.cpp, a list of AT_TIME, AT_WITH,
+AT_THEN_EVERY, AT_TILT, AT_TURN and AT_THRUST entries, in a file of its own
+or as a named AsyncTiming array of a C++ source. convert checks it as
+PACK_CUES() would and packs it (see include/ahkcue.h) behind the scene file
+header (see include/ahkstream.h). The actions, what they drive and their
+argument ranges are read from src/ahkscenes.cpp and include/, so the file
+matches the firmware built from the same tree.
+
+send types L on the console and then sends the file as the unit asks for
+it, printing the unit's log (see tools/ahklog.py) until the scene has been
+read or abandoned.
+
+    tools/ahkscene.py convert my_scene.txt my_scene.ahks
+    tools/ahkscene.py convert src/ahkscenes.cpp scene01.ahks --timings CUT_SCENE_01_TIMINGS
+    tools/ahkscene.py send my_scene.ahks --port /dev/ttyUSB0     (needs pyserial)
+    .pio/build/native/program -d 90 -f 500:my_scene.ahks | tools/ahklog.py
+"""
+import argparse
+import os
+import re
+import struct
+import sys
+
+import ahklog
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+SCENES = os.path.join(ROOT, 'src', 'ahkscenes.cpp')
+INCLUDE = os.path.join(ROOT, 'include')
+
+STREAM_MAGIC = b'AHKS'
+STREAM_VERSION = 1
+CUE_ACTION_MASK = 0x3F
+CUE_ARG = 0x40
+CUE_REPEAT = 0x80
+CUE_END = 0x3F
+
+DEFINE = re.compile(r'^\s*#define\s+(\w+)\s+(0x[0-9A-Fa-f]+|\d+)\b', re.M)
+ENTRY = re.compile(r'\b(AT_\w+)\s*\(([^()]*)\)')
+WANT = re.compile(r'Stream want (\d+)')
+FINISHED = re.compile(r'Stream (ended|stopped|error|timed out)')
+
+
+class SceneError(Exception):
+    pass
+
+
+def strip_comments(text):
+    return re.sub(r'//[^\n]*|/\*.*?\*/', '', text, flags=re.S)
+
+
+def load_defines(path):
+    """Integer #defines of every header, ACT_*, AHK_*_MIN/MAX, CUE_WINDOW..."""
+    defines = {}
+    for name in sorted(os.listdir(path)):
+        if name.endswith('.h'):
+            with open(os.path.join(path, name)) as header:
+                for m in DEFINE.finditer(header.read()):
+                    defines.setdefault(m.group(1), int(m.group(2), 0))
+    return defines
+
+
+def evaluate(expression, defines):
+    """Value of an integer expression of numbers, defines, | and +."""
+    text = re.sub(r'\b[A-Za-z_]\w*\b', lambda m: str(defines[m.group(0)]) if m.group(0) in defines else m.group(0), expression)
+    if not re.fullmatch(r'[\d\sxXa-fA-F|+\-*()]+', text):
+        raise SceneError('cannot evaluate %r' % expression)
+    return eval(text, {'__builtins__': {}})
+
+
+def array_body(text, name):
+    """Initialiser list of the array name in C++ text."""
+    m = re.search(r'\b%s\s*\[\s*\]\s*(?:PROGMEM\s*)?=\s*\{' % re.escape(name), text)
+    if not m:
+        raise SceneError('%s not found' % name)
+    depth, start = 1, m.end()
+    for i in range(start, len(text)):
+        depth += {'{': 1, '}': -1}.get(text[i], 0)
+        if not depth:
+            return text[start:i]
+    raise SceneError('%s is not closed' % name)
+
+
+def load_actions(path, defines):
+    """Action names in CUE_ACTIONS order, each's CueInfo and the helper macros."""
+    with open(path) as source:
+        text = strip_comments(source.read())
+
+    actions = [a.strip() for a in array_body(text, 'CUE_ACTIONS').split(',') if a.strip()]
+    info = []
+    for m in re.finditer(r'CUE_DRIVES(_TO)?\s*\(([^()]*(?:\([^()]*\)[^()]*)*)\)', array_body(text, 'CUE_INFO')):
+        args = [evaluate(a, defines) for a in m.group(2).split(',')]
+        info.append((args[0], args[1], args[2]) if m.group(1) else (args[0], 0, 0))
+    if len(info) != len(actions):
+        raise SceneError('CUE_INFO does not match CUE_ACTIONS')
+
+    helpers = {}  # AT_TILT(START, DEGREES) -> AT_WITH(START, tiltToCue, DEGREES)
+    for m in re.finditer(r'#define\s+(AT_\w+)\s*\(\s*START\s*,\s*\w+\s*\)\s+AT_WITH\s*\(\s*START\s*,\s*(\w+)', text):
+        helpers[m.group(1)] = m.group(2)
+    return actions, info, helpers
+
+
+def parse_scene(text, actions, helpers, defines):
+    """(start, action index, repeat, arg) for each entry, in written order."""
+    cues = []
+    for m in ENTRY.finditer(strip_comments(text)):
+        macro, args = m.group(1), [a.strip() for a in m.group(2).split(',')]
+        if macro == 'AT_TIME' and len(args) == 2:
+            start, fn, repeat, arg = args[0], args[1], '0', '0'
+        elif macro == 'AT_THEN_EVERY' and len(args) == 3:
+            start, repeat, fn, arg = args[0], args[1], args[2], '0'
+        elif macro == 'AT_WITH' and len(args) == 3:
+            start, fn, arg, repeat = args[0], args[1], args[2], '0'
+        elif macro in helpers and len(args) == 2:
+            start, fn, arg, repeat = args[0], helpers[macro], args[1], '0'
+        else:
+            raise SceneError('cannot read %s' % m.group(0))
+
+        if fn not in actions:
+            raise SceneError('%s calls %s, missing from CUE_ACTIONS' % (m.group(0), fn))
+        cues.append((evaluate(start, defines), actions.index(fn), evaluate(repeat, defines), evaluate(arg, defines)))
+    return cues
+
+
+def check(cues, info, window):
+    """Reject cues PACK_CUES() would, see include/ahkcue.h."""
+    for start, action, repeat, arg in cues:
+        drives, arg_min, arg_max = info[action]
+        if (repeat or arg < arg_min or arg > arg_max) if arg_max else arg:
+            raise SceneError('bad argument at %d ms' % start)
+
+    for j, later in enumerate(cues):
+        for earlier in reversed(cues[:j]):
+            if later[0] - earlier[0] >= window:
+                break
+            same = earlier[1] == later[1] and earlier[3] == later[3]
+            if not same and info[earlier[1]][0] & info[later[1]][0]:
+                raise SceneError('conflicting cues at %d ms' % later[0])
+
+
+def put_varint(out, value):
+    while value >= 0x80:
+        out.append((value | 0x80) & 0xFF)
+        value >>= 7
+    out.append(value)
+
+
+def pack(cues):
+    """Cue bytes ending with CUE_END, duplicates packed once as cueDuplicate()."""
+    out = bytearray()
+    last = 0
+    for i, (start, action, repeat, arg) in enumerate(cues):
+        if any(c == cues[i] for c in cues[:i] if c[0] == start):
+            continue
+        out.append(action | (CUE_REPEAT if repeat else 0) | (CUE_ARG if arg else 0))
+        put_varint(out, start - last)
+        if repeat:
+            put_varint(out, repeat)
+        if arg:
+            out.append(arg)
+        last = start
+    out.append(CUE_END)
+    return out
+
+
+def convert(args):
+    defines = load_defines(INCLUDE)
+    actions, info, helpers = load_actions(args.scenes, defines)
+    if len(actions) >= CUE_END:
+        raise SceneError('too many actions')
+
+    with open(args.source) as source:
+        text = source.read()
+    if args.timings:
+        text = array_body(strip_comments(text), args.timings)
+
+    cues = sorted(parse_scene(text, actions, helpers, defines), key=lambda c: c[0])  # Stable, as sortCues().
+    if not cues:
+        raise SceneError('no cues in %s' % args.source)
+    check(cues, info, defines['CUE_WINDOW'])
+
+    packed = pack(cues)
+    with open(args.output, 'wb') as output:
+        output.write(STREAM_MAGIC + bytes([STREAM_VERSION, len(actions)]) + struct.pack('<I', len(packed)) + packed)
+    print('%s: %d cues, %d bytes' % (args.output, len(cues), len(packed) + 10))
+
+
+class Sender:
+    """Log output that sends the file as far as each "Stream want" allows."""
+
+    def __init__(self, port, data):
+        self.port = port
+        self.data = data
+        self.sent = 0
+        self.finished = False
+
+    def write(self, text):
+        sys.stdout.write(text)
+        m = WANT.search(text)
+        if m:
+            allow = min(int(m.group(1)), len(self.data))
+            if allow > self.sent:
+                self.port.write(self.data[self.sent:allow])
+                self.sent = allow
+        if FINISHED.search(text):
+            self.finished = True
+
+    def flush(self):
+        sys.stdout.flush()
+
+
+def send(args):
+    import serial
+
+    with open(args.file, 'rb') as scene:
+        data = scene.read()
+    if data[:4] != STREAM_MAGIC:
+        raise SceneError('%s is not a scene file' % args.file)
+
+    port = serial.Serial(args.port, args.baud)
+    sender = Sender(port, data)
+    port.write(b'L')
+
+    def until_finished():
+        for b in ahklog.read_bytes(port):
+            yield b
+            if sender.finished:
+                return
+
+    try:
+        ahklog.decode(until_finished(), ahklog.load_messages(args.header), sender)
+    except KeyboardInterrupt:
+        pass
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    commands = parser.add_subparsers(dest='command', required=True)
+
+    p = commands.add_parser('convert', help='pack a scene into a scene file')
+    p.add_argument('source', help='AT_TIME list, or C++ source with --timings')
+    p.add_argument('output')
+    p.add_argument('--timings', help='AsyncTiming array of source to convert')
+    p.add_argument('--scenes', default=SCENES, help='ahkscenes.cpp listing the actions')
+    p.set_defaults(run=convert)
+
+    p = commands.add_parser('send', help='stream a scene file to the unit')
+    p.add_argument('file')
+    p.add_argument('--port', required=True, help='serial port of the unit')
+    p.add_argument('--baud', type=int, default=115200)
+    p.add_argument('--header', default=ahklog.HEADER, help='ahklog.h listing the messages')
+    p.set_defaults(run=send)
+
+    args = parser.parse_args()
+    try:
+        args.run(args)
+    except SceneError as e:
+        sys.exit('%s: %s' % (parser.prog, e))
+
+
+if __name__ == '__main__':
+    main()